@@ -0,0 +1,291 @@
+#pragma once
+#include "bezier.hpp"
+#include "mesh.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Adaptive tessellation of bicubic Bezier patches.
+//
+// Subdivision levels follow from the control polygon and an error
+// tolerance, so flat patches get few triangles and curved ones many. Each
+// boundary edge gets its own level, computed from that edge's four control
+// points only, taken in a canonical order. Neighbouring patches sharing an
+// edge therefore agree on its level and on its vertex positions, and a
+// transition strip stitches every edge to the (independently chosen)
+// interior grid. No cracks, no T-junctions.
+
+namespace kgfx {
+
+    // World space tolerance that corresponds to 'pixels' of screen space error
+    // at 'distance' in front of a perspective camera.
+    inline float screen_space_tolerance(float pixels,
+                                        float distance,
+                                        float fov_y,
+                                        float viewport_height)
+    {
+        return pixels * 2.0f * distance * std::tan(fov_y * 0.5f) / viewport_height;
+    }
+
+    namespace detail {
+
+        // Wang's formula: number of uniform segments for a cubic to stay within
+        // 'tolerance' of its chords, 3/4 * max|P[i] - 2P[i+1] + P[i+2]| / n^2.
+        template <typename Point, typename T>
+        unsigned cubic_segments(const Point& p0,
+                                const Point& p1,
+                                const Point& p2,
+                                const Point& p3,
+                                T tolerance,
+                                unsigned max_segments)
+        {
+            assert(tolerance > T(0));
+
+            const T m = std::max(glm::length(p0 - p1 * T(2) + p2),
+                                 glm::length(p1 - p2 * T(2) + p3));
+
+            const T n = std::ceil(std::sqrt(T(0.75) * m / tolerance));
+            return std::min(std::max(static_cast<unsigned>(n), 1u), max_segments);
+        }
+
+        template <typename Point>
+        bool lexicographic_less(const Point& a, const Point& b)
+        {
+            if (a.x != b.x)
+                return a.x < b.x;
+            if (a.y != b.y)
+                return a.y < b.y;
+            return a.z < b.z;
+        }
+
+        // The control points of a boundary edge, starting at the
+        // lexicographically smaller end. The patch on the other side walks the
+        // edge the other way, but gets the same points in the same order, so
+        // both compute bit-identical levels and positions. True when the
+        // order is reversed with respect to patch_edges.
+        template <typename Points, typename Point>
+        bool canonical_edge(const Points& p, int edge, Point (&curve)[4])
+        {
+            const int* e = patch_edges[edge];
+            const bool reverse = lexicographic_less(p[e[3]], p[e[0]]);
+            for (int i = 0; i < 4; ++i)
+            {
+                curve[i] = p[e[reverse ? 3 - i : i]];
+            }
+
+            return reverse;
+        }
+
+    } // namespace detail
+
+    // Subdivision levels of one patch. Edges in the order of detail::patch_edges.
+    struct Patch_levels {
+        unsigned edges[4]{1, 1, 1, 1};
+        unsigned inner_u{2};
+        unsigned inner_v{2};
+    };
+
+    //
+    template <typename Point, typename T>
+    Patch_levels patch_levels(const Bezier_patch<Point, T>& patch,
+                              T tolerance,
+                              unsigned max_level = 64)
+    {
+        const auto& p = patch.get_points();
+
+        Patch_levels levels;
+        for (int edge = 0; edge < 4; ++edge)
+        {
+            Point curve[4];
+            detail::canonical_edge(p, edge, curve);
+            levels.edges[edge] = detail::cubic_segments(curve[0], curve[1], curve[2], curve[3], tolerance, max_level);
+        }
+
+        // Interior: bound along every row (u) and column (v) of the net.
+        unsigned level_u = 1;
+        unsigned level_v = 1;
+        for (int i = 0; i < 4; ++i)
+        {
+            level_u = std::max(level_u, detail::cubic_segments(p[i * 4], p[i * 4 + 1], p[i * 4 + 2], p[i * 4 + 3], tolerance, max_level));
+            level_v = std::max(level_v, detail::cubic_segments(p[i], p[i + 4], p[i + 8], p[i + 12], tolerance, max_level));
+        }
+
+        // Twist term, 1/4 * du * dv * max|S_uv| with |S_uv| <= 9 * max twist.
+        T twist(0);
+        for (int j = 0; j < 3; ++j)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                const int k = i + j * 4;
+                twist = std::max(twist, glm::length(p[k + 5] - p[k + 4] - p[k + 1] + p[k]));
+            }
+        }
+
+        while (T(9) * twist / (T(4) * static_cast<T>(level_u * level_v)) > tolerance
+               && (level_u < max_level || level_v < max_level))
+        {
+            unsigned& smaller = (level_u < level_v && level_u < max_level) || level_v >= max_level ? level_u : level_v;
+            ++smaller;
+        }
+
+        // The transition strips need at least one interior vertex.
+        levels.inner_u = std::max(level_u, 2u);
+        levels.inner_v = std::max(level_v, 2u);
+
+        return levels;
+    }
+
+    // Generator (see mesh_generator.hpp) for an adaptively tessellated patch.
+    template <typename Point, typename T>
+    class Adaptive_patch_generator {
+    public:
+        Adaptive_patch_generator(const Bezier_patch<Point, T>& patch,
+                                 T tolerance,
+                                 unsigned max_level = 64)
+            : patch_(patch)
+            , levels_(patch_levels(patch, tolerance, max_level))
+        {
+        }
+
+    public:
+        const Patch_levels& levels() const
+        {
+            return levels_;
+        }
+
+        Mesh_size size() const
+        {
+            const unsigned inner_x = levels_.inner_u - 1;
+            const unsigned inner_y = levels_.inner_v - 1;
+
+            Mesh_size s;
+            s.num_vertices = 4 + inner_x * inner_y;
+            s.num_triangles = (inner_x - 1) * (inner_y - 1) * 2 + (inner_x - 1) * 2 + (inner_y - 1) * 2;
+            for (unsigned edge : levels_.edges)
+            {
+                s.num_vertices += edge - 1;
+                s.num_triangles += edge;
+            }
+
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            const auto& p = patch_.get_points();
+
+            auto write_vertex = [&vertices](const Point& position) {
+                Vertex v{};
+                v.position = position;
+                *vertices++ = v;
+            };
+
+            // Corners, then edge interiors, then the interior grid.
+            for (const int* e : detail::patch_edges)
+            {
+                write_vertex(p[e[0]]);
+            }
+
+            for (int edge = 0; edge < 4; ++edge)
+            {
+                write_edge_vertices(edge, write_vertex);
+            }
+
+            const unsigned inner_x = levels_.inner_u - 1;
+            const unsigned inner_y = levels_.inner_v - 1;
+            for (unsigned y = 1; y <= inner_y; ++y)
+            {
+                for (unsigned x = 1; x <= inner_x; ++x)
+                {
+                    write_vertex(patch_.sample(static_cast<T>(x) / static_cast<T>(levels_.inner_u),
+                                               static_cast<T>(y) / static_cast<T>(levels_.inner_v)));
+                }
+            }
+
+            // Interior grid, counter-clockwise in parameter space like make_patch.
+            unsigned edge_offset[4];
+            edge_offset[0] = base_vertex + 4;
+            for (int edge = 1; edge < 4; ++edge)
+            {
+                edge_offset[edge] = edge_offset[edge - 1] + levels_.edges[edge - 1] - 1;
+            }
+
+            const unsigned inner_base = edge_offset[3] + levels_.edges[3] - 1;
+            triangles = write_grid_triangles(triangles, inner_x, inner_y, inner_base);
+
+            // Transition strips. Walking each edge counter-clockwise keeps the
+            // interior on the left.
+            for (unsigned edge = 0; edge < 4; ++edge)
+            {
+                const unsigned num_outer = levels_.edges[edge];
+                const unsigned num_inner = (edge % 2 == 0) ? inner_x : inner_y;
+
+                auto outer = [&](unsigned i) {
+                    if (i == 0)
+                        return base_vertex + edge;
+                    if (i == num_outer)
+                        return base_vertex + (edge + 1) % 4;
+                    return edge_offset[edge] + i - 1;
+                };
+
+                auto inner = [&](unsigned j) {
+                    unsigned x = 0;
+                    unsigned y = 0;
+                    switch (edge) {
+                    case 0: x = j;               y = 0;               break;
+                    case 1: x = inner_x - 1;     y = j;               break;
+                    case 2: x = inner_x - 1 - j; y = inner_y - 1;     break;
+                    case 3: x = 0;               y = inner_y - 1 - j; break;
+                    }
+                    return inner_base + x + y * inner_x;
+                };
+
+                // Zip the two rows together, always advancing the one whose
+                // next vertex lies closest along the edge.
+                const unsigned num_parts = num_inner + 1;
+                unsigned i = 0;
+                unsigned j = 0;
+                while (i < num_outer || j + 1 < num_inner)
+                {
+                    const bool advance_outer = (j + 1 == num_inner)
+                                               || (i < num_outer && (i + 1) * num_parts <= (j + 2) * num_outer);
+                    if (advance_outer)
+                    {
+                        *triangles++ = Triangle(outer(i), outer(i + 1), inner(j));
+                        ++i;
+                    }
+                    else
+                    {
+                        *triangles++ = Triangle(outer(i), inner(j + 1), inner(j));
+                        ++j;
+                    }
+                }
+            }
+        }
+
+    private:
+        // Samples the interior of a boundary curve from its control points only,
+        // in canonical order (see detail::canonical_edge).
+        template <typename Write>
+        void write_edge_vertices(int edge, Write& write_vertex) const
+        {
+            const unsigned num_segments = levels_.edges[edge];
+
+            Point curve[4];
+            const bool reverse = detail::canonical_edge(patch_.get_points(), edge, curve);
+
+            for (unsigned i = 1; i < num_segments; ++i)
+            {
+                const unsigned k = reverse ? num_segments - i : i;
+                write_vertex(detail::sample<3>(curve, static_cast<T>(k) / static_cast<T>(num_segments)));
+            }
+        }
+
+        const Bezier_patch<Point, T>& patch_;
+        Patch_levels levels_;
+    };
+
+} // namespace kgfx
@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace kgfx {
+
+    namespace detail {
+
+        // 5 point Gauss-Legendre rule on [a, b], exact for polynomials up to degree 9.
+        template <typename T, typename Speed>
+        T gauss_legendre_5(const Speed& speed, T a, T b)
+        {
+            static const T nodes[5] = {T(0),
+                                       T(-0.5384693101056831), T(0.5384693101056831),
+                                       T(-0.9061798459386640), T(0.9061798459386640)};
+            static const T weights[5] = {T(0.5688888888888889),
+                                         T(0.4786286704993665), T(0.4786286704993665),
+                                         T(0.2369268850561891), T(0.2369268850561891)};
+
+            const T half = (b - a) * T(0.5);
+            const T center = (a + b) * T(0.5);
+
+            T sum(0);
+            for (int i = 0; i < 5; ++i)
+            {
+                sum += weights[i] * speed(center + half * nodes[i]);
+            }
+
+            return sum * half;
+        }
+
+        // Cubic Hermite interpolation on one segment, end slopes limited to
+        // [0, 3 * secant] so the interpolant is monotone (Fritsch-Carlson).
+        template <typename T>
+        T monotone_hermite(T x0, T x1, T y0, T y1, T m0, T m1, T x)
+        {
+            const T h = x1 - x0;
+            if (!(h > T(0))) {
+                return y0;
+            }
+
+            const T secant = (y1 - y0) / h;
+            m0 = std::min(std::max(m0, T(0)), T(3) * secant);
+            m1 = std::min(std::max(m1, T(0)), T(3) * secant);
+
+            const T s = (x - x0) / h;
+            const T s2 = s * s;
+            const T s3 = s2 * s;
+
+            return y0 * (T(2) * s3 - T(3) * s2 + T(1))
+                 + m0 * h * (s3 - T(2) * s2 + s)
+                 + y1 * (T(3) * s2 - T(2) * s3)
+                 + m1 * h * (s3 - s2);
+        }
+
+    } // namespace detail
+
+    // Arc length of a parametric curve over t in [0, 1], tabulated once.
+    //
+    // The table is built from the curve's speed |C'(t)| by adaptive
+    // Gauss-Legendre quadrature: an interval is split until the quadrature and
+    // the interpolant both agree with the two halves to within the tolerance.
+    // Between the nodes s(t) and t(s) are monotone cubic Hermite
+    // interpolations using the exact speed, so looking up the parameter for a
+    // distance never moves backwards. s(t) is a binary search; t(s) goes
+    // through a uniform bucket index over distance and is O(1) on average.
+    template <typename T>
+    class Arc_length_table {
+    public:
+        Arc_length_table() = default;
+
+        // 'speed(t)' returns |C'(t)|. 'tolerance' bounds the arc length error
+        // of the whole table.
+        template <typename Speed>
+        Arc_length_table(const Speed& speed, T tolerance, unsigned max_depth = 16)
+        {
+            assert(tolerance > T(0));
+
+            parameters_.push_back(T(0));
+            distances_.push_back(T(0));
+            speeds_.push_back(speed(T(0)));
+
+            const T end_speed = speed(T(1));
+            subdivide(speed, T(0), T(1), speeds_.back(), end_speed,
+                      detail::gauss_legendre_5(speed, T(0), T(1)), tolerance, max_depth);
+
+            build_index();
+        }
+
+    public:
+        T length() const
+        {
+            return distances_.empty() ? T(0) : distances_.back();
+        }
+
+        // Number of table nodes, including both ends.
+        std::size_t size() const
+        {
+            return parameters_.size();
+        }
+
+        // Arc length from the start of the curve to parameter 't'.
+        T distance(T t) const
+        {
+            if (parameters_.size() < 2) {
+                return T(0);
+            }
+
+            t = std::min(std::max(t, T(0)), T(1));
+            const auto it = std::upper_bound(parameters_.begin() + 1, parameters_.end() - 1, t);
+            const std::size_t i = static_cast<std::size_t>(it - parameters_.begin()) - 1;
+
+            return detail::monotone_hermite(parameters_[i], parameters_[i + 1],
+                                            distances_[i], distances_[i + 1],
+                                            speeds_[i], speeds_[i + 1],
+                                            t);
+        }
+
+        // Parameter at arc length 's' from the start, clamped to the curve.
+        T parameter(T s) const
+        {
+            if (parameters_.size() < 2 || !(length() > T(0))) {
+                return T(0);
+            }
+
+            s = std::min(std::max(s, T(0)), length());
+            const std::size_t i = segment_at(s);
+
+            return detail::monotone_hermite(distances_[i], distances_[i + 1],
+                                            parameters_[i], parameters_[i + 1],
+                                            inverse_speed(i), inverse_speed(i + 1),
+                                            s);
+        }
+
+        // Batched versions, e.g. one query per object moving along the curve.
+        void distances(const T* parameters, T* out, std::size_t count) const
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = distance(parameters[i]);
+            }
+        }
+
+        void parameters(const T* distances, T* out, std::size_t count) const
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = parameter(distances[i]);
+            }
+        }
+
+    private:
+        template <typename Speed>
+        void subdivide(const Speed& speed,
+                       T a,
+                       T b,
+                       T speed_a,
+                       T speed_b,
+                       T whole,
+                       T tolerance,
+                       unsigned depth)
+        {
+            const T m = (a + b) * T(0.5);
+            const T left = detail::gauss_legendre_5(speed, a, m);
+            const T right = detail::gauss_legendre_5(speed, m, b);
+            const T s_a = distances_.back();
+
+            // Both the integral and the Hermite interpolant at the quarter
+            // points must hold up against the refined estimate. (The midpoint
+            // alone is blind to errors of symmetric segments.)
+            const T local_tolerance = tolerance * (b - a);
+            const T q1 = (a + m) * T(0.5);
+            const T q3 = (m + b) * T(0.5);
+            const T s_b = s_a + left + right;
+            const T error_q1 = detail::monotone_hermite(a, b, s_a, s_b, speed_a, speed_b, q1)
+                             - (s_a + detail::gauss_legendre_5(speed, a, q1));
+            const T error_q3 = detail::monotone_hermite(a, b, s_a, s_b, speed_a, speed_b, q3)
+                             - (s_a + left + detail::gauss_legendre_5(speed, m, q3));
+
+            if (depth == 0
+                || (std::abs(left + right - whole) <= local_tolerance
+                    && std::abs(error_q1) <= local_tolerance
+                    && std::abs(error_q3) <= local_tolerance))
+            {
+                parameters_.push_back(b);
+                distances_.push_back(s_b);
+                speeds_.push_back(speed_b);
+                return;
+            }
+
+            const T speed_m = speed(m);
+            subdivide(speed, a, m, speed_a, speed_m, left, tolerance, depth - 1);
+            subdivide(speed, m, b, speed_m, speed_b, right, tolerance, depth - 1);
+        }
+
+        // Bucket k holds the first segment reaching distance k * length / buckets.
+        void build_index()
+        {
+            const std::size_t num_segments = parameters_.size() - 1;
+            index_.assign(num_segments, 0);
+
+            std::size_t segment = 0;
+            for (std::size_t k = 0; k < num_segments; ++k)
+            {
+                const T s = length() * static_cast<T>(k) / static_cast<T>(num_segments);
+                while (segment + 1 < num_segments && distances_[segment + 1] <= s)
+                {
+                    ++segment;
+                }
+                index_[k] = static_cast<unsigned>(segment);
+            }
+        }
+
+        std::size_t segment_at(T s) const
+        {
+            const std::size_t num_segments = index_.size();
+            const std::size_t bucket = std::min(static_cast<std::size_t>(s / length() * static_cast<T>(num_segments)),
+                                                num_segments - 1);
+
+            std::size_t segment = index_[bucket];
+            while (segment + 1 < num_segments && distances_[segment + 1] < s)
+            {
+                ++segment;
+            }
+
+            return segment;
+        }
+
+        // dt/ds at node i; infinite where the curve stops, which the slope
+        // limiter in monotone_hermite turns into the steepest monotone slope.
+        T inverse_speed(std::size_t i) const
+        {
+            return speeds_[i] > T(0) ? T(1) / speeds_[i] : T(HUGE_VAL);
+        }
+
+        std::vector<T> parameters_;
+        std::vector<T> distances_;
+        std::vector<T> speeds_;
+        std::vector<unsigned> index_;
+    };
+
+} // namespace kgfx
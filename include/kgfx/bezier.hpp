@@ -1,6 +1,13 @@
 #pragma once
+#include "arc_length.hpp"
+#include "bounding_box.hpp"
+#include "parallel.hpp"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
 #include <initializer_list>
+#include <utility>
 #include <vector>
 
 namespace kgfx {
@@ -20,115 +27,192 @@ namespace kgfx {
             return a * t0 + b * t1;
         }
 
-        template <typename T>
-        T pow2(T t)
+        // de Casteljau split of a cubic at 't'. Control points 'stride' apart;
+        // the halves are written with the same stride.
+        template <typename Point, typename T>
+        void split_cubic(const Point* p, int stride, T t, Point* lower, Point* upper)
         {
-            return t * t;
+            const Point p01 = lerp(p[0], p[stride], t);
+            const Point p12 = lerp(p[stride], p[2 * stride], t);
+            const Point p23 = lerp(p[2 * stride], p[3 * stride], t);
+            const Point p012 = lerp(p01, p12, t);
+            const Point p123 = lerp(p12, p23, t);
+            const Point p0123 = lerp(p012, p123, t);
+
+            lower[0] = p[0];
+            lower[stride] = p01;
+            lower[2 * stride] = p012;
+            lower[3 * stride] = p0123;
+
+            upper[0] = p0123;
+            upper[stride] = p123;
+            upper[2 * stride] = p23;
+            upper[3 * stride] = p[3 * stride];
         }
 
-        template <typename T>
-        T pow3(T t)
+        // Binomial coefficient C(n, k), at compile time where used as such.
+        constexpr long long binomial(int n, int k)
         {
-            return pow2(t) * t;
+            if (k < 0 || k > n) {
+                return 0;
+            }
+
+            long long c = 1;
+            for (int i = 1; i <= k; ++i)
+            {
+                c = c * (n - k + i) / i;
+            }
+            return c;
         }
 
-        template <typename T>
-        T pow4(T t)
+        template <int n, typename T>
+        constexpr T power(T x)
         {
-            return pow2(t) * pow2(t);
+            T p(1);
+            for (int i = 0; i < n; ++i)
+            {
+                p *= x;
+            }
+            return p;
         }
 
+        // Bernstein basis polynomial C(degree, n) * x^n * (1 - x)^(degree - n),
+        // any degree, computed in T throughout. Zero outside 0 <= n <= degree.
         template <int degree, int n>
         struct Bernstein {
-            template <typename T>
-            static T value(T x);
-        };
-
-        template <int n>
-        struct Bernstein<0, n> {
             template <typename T>
             static T value(T x)
             {
-                return T(1);
+                if constexpr (n < 0 || n > degree) {
+                    return T(0);
+                } else {
+                    constexpr T c = static_cast<T>(binomial(degree, n));
+                    return c * power<n>(x) * power<degree - n>(T(1) - x);
+                }
             }
         };
 
-        template <int n>
-        struct Bernstein<1, n> {
+        // d/dx Bernstein<degree, n> = degree * (Bernstein<degree - 1, n - 1> - Bernstein<degree - 1, n>).
+        template <int degree, int n>
+        struct Bernstein_derivative {
             template <typename T>
             static T value(T x)
             {
-                switch (n) {
-                case 0:
-                    return T(1) - x;
-                case 1:
-                    return x;
+                T d(0);
+                if constexpr (n > 0) {
+                    d += Bernstein<degree - 1, n - 1>::value(x);
                 }
-
-                return T(0);
+                if constexpr (n < degree) {
+                    d -= Bernstein<degree - 1, n>::value(x);
+                }
+                return T(degree) * d;
             }
         };
 
-        template <int n>
-        struct Bernstein<2, n> {
-            template <typename T>
-            static T value(T x)
+        template <int degree, typename T, template <int, int> class Basis, std::size_t... n>
+        std::array<T, degree + 1> bernstein_basis(T t, std::index_sequence<n...>)
+        {
+            return {{Basis<degree, static_cast<int>(n)>::value(t)...}};
+        }
+
+        // All degree + 1 basis functions (or their derivatives) at 't'.
+        template <int degree, typename T, template <int, int> class Basis = Bernstein>
+        std::array<T, degree + 1> bernstein_basis(T t)
+        {
+            return bernstein_basis<degree, T, Basis>(t, std::make_index_sequence<degree + 1>());
+        }
+
+        // Basis functions at 'num_samples' uniformly spaced parameter values,
+        // first and last exactly at 0 and 1. One row per parameter value.
+        template <int degree, typename T, template <int, int> class Basis = Bernstein>
+        std::vector<std::array<T, degree + 1>> bernstein_table(unsigned num_samples)
+        {
+            std::vector<std::array<T, degree + 1>> table(num_samples);
+
+            const T last = static_cast<T>(num_samples > 1 ? num_samples - 1 : 1);
+            for (unsigned i = 0; i < num_samples; ++i)
             {
-                switch (n) {
-                case 0:
-                    return pow2(T(1) - x);
-                case 1:
-                    return T(2) * x * (T(1) - x);
-                case 2:
-                    return pow2(x);
-                }
+                table[i] = bernstein_basis<degree, T, Basis>(static_cast<T>(i) / last);
+            }
+
+            return table;
+        }
 
-                return T(0);
+        // Unit length cross(du, dv). False when the tangents are (nearly)
+        // parallel or zero and no normal can be derived from them.
+        template <typename Point, typename T>
+        bool unit_normal(const Point& du, const Point& dv, Point& normal)
+        {
+            const Point n = cross(du, dv);
+            const T length2 = dot(n, n);
+            if (length2 <= T(1e-10) * dot(du, du) * dot(dv, dv) || !(length2 > T(0)))
+            {
+                return false;
             }
-        };
 
-        template <int n>
-        struct Bernstein<3, n> {
-            template <typename T>
-            static T value(T x)
+            normal = n / std::sqrt(length2);
+            return true;
+        }
+
+        // Horner's scheme in Bernstein form: sum of C(degree, i) * P[i] * t^i * s^(degree - i)
+        // with s = 1 - t, accumulated as ((P0 s + c1 t P1) s + c2 t^2 P2) s ... in
+        // O(degree), no divisions. Binomials are compile time constants.
+        template <int degree, typename Point, typename T>
+        inline Point horner(const Point* points, T t)
+        {
+            static_assert(degree > 0, "Degree must be positive.");
+
+            const T s = T(1) - t;
+            T t_power = T(1);
+            Point sum = points[0] * s;
+
+            for (int i = 1; i < degree; ++i)
             {
-                switch (n) {
-                case 0:
-                    return pow3(T(1) - x);
-                case 1:
-                    return T(3) * x * pow2(T(1) - x);
-                case 2:
-                    return T(3) * pow2(x) * (T(1) - x);
-                case 3:
-                    return pow3(x);
+                t_power *= t;
+                sum = (sum + points[i] * (t_power * static_cast<T>(binomial(degree, i)))) * s;
+            }
+
+            return sum + points[degree] * (t_power * t);
+        }
+
+        // de Casteljau: repeated linear interpolation, unrolled at compile time.
+        // More operations than Horner, but every step is a convex combination,
+        // which keeps it stable near the ends and for high degrees.
+        template <int degree>
+        struct De_casteljau {
+            template <typename Point, typename T>
+            static Point reduce(Point* points, T t, T s)
+            {
+                for (int i = 0; i < degree; ++i)
+                {
+                    points[i] = points[i] * s + points[i + 1] * t;
                 }
 
-                return T(0);
+                return De_casteljau<degree - 1>::reduce(points, t, s);
             }
         };
 
-        template <int n>
-        struct Bernstein<4, n> {
-            template <typename T>
-            static T value(T x)
+        template <>
+        struct De_casteljau<0> {
+            template <typename Point, typename T>
+            static Point reduce(Point* points, T, T)
             {
-                switch (n) {
-                case 0:
-                    return pow4(1.0 - x);
-                case 1:
-                    return T(4) * x * pow3(T(1) - x);
-                case 2:
-                    return T(6) * pow2(x) * pow2(T(1) - x);
-                case 3:
-                    return T(4) * pow3(x) * (T(1) - x);
-                case 4:
-                    return pow4(x);
-                }
-
-                return T(0);
+                return points[0];
             }
         };
 
+        template <int degree, typename Point, typename T>
+        inline Point de_casteljau(const Point* points, T t)
+        {
+            Point tmp[degree + 1];
+            for (int i = 0; i <= degree; ++i)
+            {
+                tmp[i] = points[i];
+            }
+
+            return De_casteljau<degree>::reduce(tmp, t, T(1) - t);
+        }
+
         template <typename Point, typename T, int degree, int n>
         struct Curve_sampler {
 
@@ -211,12 +295,133 @@ namespace kgfx {
 			return sample<3>(&tmp[0], t1);*/
         }
 
+        // Boundary curves of a bicubic patch, counter-clockwise in parameter
+        // space: v = 0, u = 1, v = 1, u = 0. Control point indices in curve order.
+        constexpr int patch_edges[4][4] = {{0, 1, 2, 3},
+                                           {3, 7, 11, 15},
+                                           {15, 14, 13, 12},
+                                           {12, 8, 4, 0}};
+
+        // Steps a cubic Bezier curve in uniform parameter increments with three
+        // additions per sample. Float error grows with every step, so callers
+        // re-anchor (recompute the differences exactly) at regular intervals.
+        template <typename Point, typename T>
+        class Cubic_forward_differences {
+        public:
+            Cubic_forward_differences(const Point* points, T step)
+                : a_(points[3] - points[0] + (points[1] - points[2]) * T(3))
+                , b_((points[0] + points[2]) * T(3) - points[1] * T(6))
+                , c_((points[1] - points[0]) * T(3))
+                , d_(points[0])
+                , h_(step)
+            {
+                anchor(T(0));
+            }
+
+        public:
+            // Exact differences at 't' (power basis a*t^3 + b*t^2 + c*t + d).
+            void anchor(T t)
+            {
+                const T h2 = h_ * h_;
+                const T h3 = h2 * h_;
+
+                value_ = ((a_ * t + b_) * t + c_) * t + d_;
+                d1_ = a_ * (T(3) * t * t * h_ + T(3) * t * h2 + h3) + b_ * (T(2) * t * h_ + h2) + c_ * h_;
+                d2_ = a_ * (T(6) * t * h2 + T(6) * h3) + b_ * (T(2) * h2);
+                d3_ = a_ * (T(6) * h3);
+            }
+
+            void step()
+            {
+                value_ += d1_;
+                d1_ += d2_;
+                d2_ += d3_;
+            }
+
+            const Point& value() const
+            {
+                return value_;
+            }
+
+        private:
+            Point a_;
+            Point b_;
+            Point c_;
+            Point d_;
+            T h_;
+
+            Point value_;
+            Point d1_;
+            Point d2_;
+            Point d3_;
+        };
+
+        // Steps between re-anchoring. Keeps float drift well below 1e-5 of the
+        // control polygon size.
+        constexpr unsigned forward_difference_anchor_interval = 16;
+
+        // Calls out(i, point) for 'num_samples' uniformly spaced samples in [0, 1].
+        template <typename Point, typename T, typename Output>
+        void forward_difference_curve(const Point* points,
+                                      unsigned num_samples,
+                                      Output out,
+                                      unsigned anchor_interval = forward_difference_anchor_interval)
+        {
+            const T last = static_cast<T>(num_samples > 1 ? num_samples - 1 : 1);
+            Cubic_forward_differences<Point, T> curve(points, T(1) / last);
+
+            for (unsigned i = 0; i < num_samples; ++i)
+            {
+                if (i > 0)
+                {
+                    if (i % anchor_interval == 0)
+                    {
+                        curve.anchor(static_cast<T>(i) / last);
+                    }
+                    else
+                    {
+                        curve.step();
+                    }
+                }
+
+                out(i, curve.value());
+            }
+        }
+
+        // Grid rows per parallel_for task, so each task samples enough points
+        // to be worth a thread.
+        inline unsigned rows_per_thread(unsigned num_u)
+        {
+            const unsigned min_samples_per_thread = 16 * 1024;
+            return std::max(min_samples_per_thread / std::max(num_u, 1u), 1u);
+        }
+
     } // namespace detail
 
     template <typename Point, typename T, size_t size>
     Point sample(const std::array<Point, size>& points, T t)
     {
-        return detail::sample(&points[0], t);
+        return detail::sample<size - 1>(&points[0], t);
+    }
+
+    // Evaluates one curve of any degree at 'count' parameter values. The
+    // parameters are independent, so the loop vectorizes over them.
+    template <int degree, typename Point, typename T>
+    void evaluate_horner(const Point* points, const T* t, Point* out, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = detail::horner<degree>(points, t[i]);
+        }
+    }
+
+    template <int degree, typename Point, typename T>
+    void evaluate_de_casteljau(const Point* points, const T* t, Point* out, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = detail::de_casteljau<degree>(points, t[i]);
+        }
     }
 
     template <typename Point, typename T, size_t size>
@@ -227,16 +432,25 @@ namespace kgfx {
 
     using detail::sample_patch;
 
-    /*template <typename Point, typename T>
-	inline Point sample_patch_weight(const Point* patch, const T* weights, T t0, T t1)
-	{
-		const Point tmp[4] = { 	sample_weight<3>(&patch[0], 	&weights[0], 	t0), 
-								sample_weight<3>(&patch[4], 	&weights[4], 	t0), 
-								sample_weight<3>(&patch[8], 	&weights[8], 	t0), 
-								sample_weight<3>(&patch[12], 	&weights[12], 	t0) };
+    // Rational patch sample. Weighted points and weights are summed with the
+    // same basis products, one division.
+    template <typename Point, typename T>
+    inline Point sample_patch_weight(const Point* patch, const T* weights, T t0, T t1)
+    {
+        const auto bu = detail::bernstein_basis<3, T>(t0);
+        const auto bv = detail::bernstein_basis<3, T>(t1);
+
+        Point sum = patch[0] * (weights[0] * bu[0] * bv[0]);
+        T weight_sum = weights[0] * bu[0] * bv[0];
+        for (int k = 1; k < 4 * 4; ++k)
+        {
+            const T w = weights[k] * bu[k % 4] * bv[k / 4];
+            sum += patch[k] * w;
+            weight_sum += w;
+        }
 
-		return sample<3>(&tmp[0], t1);
-	}*/
+        return sum / weight_sum;
+    }
 
     //
     template <typename Point, typename T, int degree>
@@ -255,11 +469,93 @@ namespace kgfx {
             return sample_weight(points_, weights_, t);
         }
 
+        // Tangent C'(t). With C = N / W, C' = (N' - C * W') / W.
+        Point derivative(T t) const
+        {
+            const auto basis = detail::bernstein_basis<degree - 1, T>(t);
+            const auto basis_derivative = detail::bernstein_basis<degree - 1, T, detail::Bernstein_derivative>(t);
+
+            Point numerator = points_[0] * (weights_[0] * basis[0]);
+            Point numerator_derivative = points_[0] * (weights_[0] * basis_derivative[0]);
+            T weight = weights_[0] * basis[0];
+            T weight_derivative = weights_[0] * basis_derivative[0];
+            for (int i = 1; i < degree; ++i)
+            {
+                numerator += points_[i] * (weights_[i] * basis[i]);
+                numerator_derivative += points_[i] * (weights_[i] * basis_derivative[i]);
+                weight += weights_[i] * basis[i];
+                weight_derivative += weights_[i] * basis_derivative[i];
+            }
+
+            return (numerator_derivative - numerator * (weight_derivative / weight)) / weight;
+        }
+
+        // Arc length lookup table, built once, for constant speed motion along
+        // the curve. 'tolerance' is the largest arc length error accepted.
+        Arc_length_table<T> arc_length_table(T tolerance) const
+        {
+            return Arc_length_table<T>([this](T t) {
+                const Point d = derivative(t);
+                return std::sqrt(dot(d, d));
+            }, tolerance);
+        }
+
+        // Calls out(i, point) for 'num_samples' uniformly spaced samples in [0, 1],
+        // using forward differences. Cubic curves only. The weighted points and
+        // the weights are differenced separately, one division per sample.
+        template <typename Output>
+        void sample_uniform(unsigned num_samples, Output out) const
+        {
+            static_assert(degree == 4, "Forward differencing is implemented for cubic curves.");
+
+            Point weighted[degree];
+            for (int i = 0; i < degree; ++i)
+            {
+                weighted[i] = points_[i] * weights_[i];
+            }
+
+            const T last = static_cast<T>(num_samples > 1 ? num_samples - 1 : 1);
+            detail::Cubic_forward_differences<Point, T> numerator(weighted, T(1) / last);
+            detail::Cubic_forward_differences<T, T> denominator(&weights_[0], T(1) / last);
+
+            for (unsigned i = 0; i < num_samples; ++i)
+            {
+                if (i > 0)
+                {
+                    if (i % detail::forward_difference_anchor_interval == 0)
+                    {
+                        const T t = static_cast<T>(i) / last;
+                        numerator.anchor(t);
+                        denominator.anchor(t);
+                    }
+                    else
+                    {
+                        numerator.step();
+                        denominator.step();
+                    }
+                }
+
+                out(i, numerator.value() / denominator.value());
+            }
+        }
+
         const auto& get_points() const
         {
             return points_;
         }
 
+        const auto& get_weights() const
+        {
+            return weights_;
+        }
+
+        // Box around the control points, which holds the whole curve as long
+        // as the weights are positive.
+        Bounding_box<Point> bounding_box() const
+        {
+            return kgfx::bounding_box(points_.begin(), points_.end());
+        }
+
     private:
         std::array<Point, degree> points_;
         std::array<T, degree> weights_;
@@ -280,13 +576,345 @@ namespace kgfx {
             return sample_patch(&points_[0], tx, ty);
         }
 
+        // Partial derivatives, from the derivative Bernstein basis.
+        Point derivative_u(T u, T v) const
+        {
+            Point row[4];
+            collapse_v(detail::bernstein_basis<3, T>(v), row);
+            return combine_u(row, detail::bernstein_basis<3, T, detail::Bernstein_derivative>(u));
+        }
+
+        Point derivative_v(T u, T v) const
+        {
+            Point row[4];
+            collapse_v(detail::bernstein_basis<3, T, detail::Bernstein_derivative>(v), row);
+            return combine_u(row, detail::bernstein_basis<3, T>(u));
+        }
+
+        // Unit surface normal, cross(d/du, d/dv). Where the tangents vanish or
+        // are parallel (collapsed edges, degenerate corners) the normal is
+        // taken at points moving towards the patch center, which converge to
+        // the limit normal. Zero for a fully degenerate patch.
+        Point normal(T u, T v) const
+        {
+            Point n = derivative_u(u, v) * T(0);
+
+            T step = T(1) / T(4096);
+            for (int attempt = 0; attempt < 7; ++attempt, step *= T(4))
+            {
+                if (detail::unit_normal<Point, T>(derivative_u(u, v), derivative_v(u, v), n))
+                {
+                    break;
+                }
+
+                u += (T(0.5) - u) * step;
+                v += (T(0.5) - v) * step;
+            }
+
+            return n;
+        }
+
+        // Samples a num_u * num_v grid over [0, 1]^2 and calls out(x, y, point)
+        // for each sample. The basis functions are tabulated once per row and
+        // column, each row then collapses the patch to a cubic curve that is
+        // evaluated along u. Rows are distributed over threads on dense grids,
+        // so 'out' must be safe to call concurrently for distinct samples.
+        template <typename Output>
+        void sample_grid(unsigned num_u,
+                         unsigned num_v,
+                         Output out) const
+        {
+            const auto basis_u = detail::bernstein_table<3, T>(num_u);
+            const auto basis_v = detail::bernstein_table<3, T>(num_v);
+
+            auto sample_row = [&](unsigned y) {
+                Point row[4];
+                collapse_v(basis_v[y], row);
+
+                for (unsigned x = 0; x < num_u; ++x)
+                {
+                    out(x, y, combine_u(row, basis_u[x]));
+                }
+            };
+
+            parallel_for(0, num_v, sample_row, detail::rows_per_thread(num_u));
+        }
+
+        // Row major, 'out' must hold num_u * num_v points.
+        void sample_grid(unsigned num_u,
+                         unsigned num_v,
+                         Point* out) const
+        {
+            sample_grid(num_u, num_v, [out, num_u](unsigned x, unsigned y, const Point& p) {
+                out[x + y * num_u] = p;
+            });
+        }
+
+        // Like sample_grid, but calls out(x, y, point, normal) with the exact
+        // unit surface normal. Derivative bases are tabulated alongside the
+        // position bases, so each sample costs three row combinations.
+        template <typename Output>
+        void sample_grid_normals(unsigned num_u,
+                                 unsigned num_v,
+                                 Output out) const
+        {
+            const auto basis_u = detail::bernstein_table<3, T>(num_u);
+            const auto basis_v = detail::bernstein_table<3, T>(num_v);
+            const auto derivative_basis_u = detail::bernstein_table<3, T, detail::Bernstein_derivative>(num_u);
+            const auto derivative_basis_v = detail::bernstein_table<3, T, detail::Bernstein_derivative>(num_v);
+
+            auto sample_row = [&](unsigned y) {
+                Point row[4];
+                Point row_dv[4];
+                collapse_v(basis_v[y], row);
+                collapse_v(derivative_basis_v[y], row_dv);
+
+                for (unsigned x = 0; x < num_u; ++x)
+                {
+                    Point n;
+                    if (!detail::unit_normal<Point, T>(combine_u(row, derivative_basis_u[x]),
+                                                       combine_u(row_dv, basis_u[x]),
+                                                       n))
+                    {
+                        n = normal(static_cast<T>(x) / static_cast<T>(std::max(num_u, 2u) - 1),
+                                   static_cast<T>(y) / static_cast<T>(std::max(num_v, 2u) - 1));
+                    }
+
+                    out(x, y, combine_u(row, basis_u[x]), n);
+                }
+            };
+
+            parallel_for(0, num_v, sample_row, detail::rows_per_thread(num_u));
+        }
+
+        // Same output as sample_grid, evaluated with forward differences: the
+        // four column curves are stepped along v, and each row curve along u.
+        // Runs on the calling thread, in row order.
+        template <typename Output>
+        void sample_grid_forward(unsigned num_u,
+                                 unsigned num_v,
+                                 Output out) const
+        {
+            const T last_v = static_cast<T>(num_v > 1 ? num_v - 1 : 1);
+
+            std::array<detail::Cubic_forward_differences<Point, T>, 4> columns = {{
+                column_forward_differences(0, T(1) / last_v),
+                column_forward_differences(1, T(1) / last_v),
+                column_forward_differences(2, T(1) / last_v),
+                column_forward_differences(3, T(1) / last_v)}};
+
+            for (unsigned y = 0; y < num_v; ++y)
+            {
+                if (y > 0)
+                {
+                    for (auto& column : columns)
+                    {
+                        if (y % detail::forward_difference_anchor_interval == 0)
+                        {
+                            column.anchor(static_cast<T>(y) / last_v);
+                        }
+                        else
+                        {
+                            column.step();
+                        }
+                    }
+                }
+
+                const Point row[4] = {columns[0].value(), columns[1].value(), columns[2].value(), columns[3].value()};
+                detail::forward_difference_curve<Point, T>(row, num_u, [&out, y](unsigned x, const Point& p) {
+                    out(x, y, p);
+                });
+            }
+        }
+
+        void sample_grid_forward(unsigned num_u,
+                                 unsigned num_v,
+                                 Point* out) const
+        {
+            sample_grid_forward(num_u, num_v, [out, num_u](unsigned x, unsigned y, const Point& p) {
+                out[x + y * num_u] = p;
+            });
+        }
+
+        // Splits at 'u' into the patches over [0, u] and [u, 1].
+        void split_u(T u, Bezier_patch& lower, Bezier_patch& upper) const
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                detail::split_cubic(&points_[j * 4], 1, u, &lower.points_[j * 4], &upper.points_[j * 4]);
+            }
+        }
+
+        // Splits at 'v' into the patches over [0, v] and [v, 1].
+        void split_v(T v, Bezier_patch& lower, Bezier_patch& upper) const
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                detail::split_cubic(&points_[i], 4, v, &lower.points_[i], &upper.points_[i]);
+            }
+        }
+
+        // Box around the control points (convex hull property).
+        Bounding_box<Point> bounding_box() const
+        {
+            return kgfx::bounding_box(points_.begin(), points_.end());
+        }
+
+        // Tighter box: the union of the control point boxes of the 4^levels
+        // sub-patches. The control net converges to the surface quadratically
+        // under subdivision, so one or two levels are usually enough.
+        Bounding_box<Point> bounding_box(unsigned levels) const
+        {
+            if (levels == 0) {
+                return bounding_box();
+            }
+
+            Bounding_box<Point> box(points_[0]);
+            for_each_quadrant([&](const Bezier_patch& quadrant) {
+                box.extend(quadrant.bounding_box(levels - 1));
+            });
+
+            return box;
+        }
+
+        // Calls fun(quadrant) for the four sub-patches over [0, 1/2]^2,
+        // [1/2, 1] x [0, 1/2], [0, 1/2] x [1/2, 1] and [1/2, 1]^2, in that order.
+        template <typename Fun>
+        void for_each_quadrant(Fun fun) const
+        {
+            Bezier_patch lower(points_);
+            Bezier_patch upper(points_);
+            split_v(T(0.5), lower, upper);
+
+            for (const Bezier_patch* half : {&lower, &upper})
+            {
+                Bezier_patch left(points_);
+                Bezier_patch right(points_);
+                half->split_u(T(0.5), left, right);
+                fun(left);
+                fun(right);
+            }
+        }
+
+        const auto& get_points() const
+        {
+            return points_;
+        }
+
+    private:
+        // Collapses the patch along v into the control points of a cubic in u.
+        void collapse_v(const std::array<T, 4>& bv, Point* row) const
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                row[i] = points_[i] * bv[0] + points_[i + 4] * bv[1] + points_[i + 8] * bv[2] + points_[i + 12] * bv[3];
+            }
+        }
+
+        static Point combine_u(const Point* row, const std::array<T, 4>& bu)
+        {
+            return row[0] * bu[0] + row[1] * bu[1] + row[2] * bu[2] + row[3] * bu[3];
+        }
+
+        detail::Cubic_forward_differences<Point, T> column_forward_differences(int i, T step) const
+        {
+            const Point column[4] = {points_[i], points_[i + 4], points_[i + 8], points_[i + 12]};
+            return detail::Cubic_forward_differences<Point, T>(column, step);
+        }
+
+        std::array<Point, 4 * 4> points_;
+    };
+
+    // Rational bicubic patch, for exact conics (cylinders, spheres, tori).
+    // Control points are kept in homogeneous form, (w * P, w), so evaluation
+    // is a polynomial patch in four dimensions followed by one division.
+    template <typename Point, typename T>
+    class Rational_bezier_patch {
+    public:
+        Rational_bezier_patch(const std::array<Point, 4 * 4>& points,
+                              const std::array<T, 4 * 4>& weights)
+            : points_(points)
+            , weights_(weights)
+        {
+            for (int k = 0; k < 4 * 4; ++k)
+            {
+                weighted_points_[k] = points[k] * weights[k];
+            }
+        }
+
+    public:
+        Point sample(T tx, T ty) const
+        {
+            Point row[4];
+            T row_weights[4];
+            collapse_v(detail::bernstein_basis<3, T>(ty), row, row_weights);
+            return project(row, row_weights, detail::bernstein_basis<3, T>(tx));
+        }
+
+        // Samples a num_u * num_v grid over [0, 1]^2 and calls out(x, y, point)
+        // for each sample. Basis tables are shared by all samples and each row
+        // collapses to a rational cubic, as in Bezier_patch::sample_grid.
+        template <typename Output>
+        void sample_grid(unsigned num_u,
+                         unsigned num_v,
+                         Output out) const
+        {
+            const auto basis_u = detail::bernstein_table<3, T>(num_u);
+            const auto basis_v = detail::bernstein_table<3, T>(num_v);
+
+            auto sample_row = [&](unsigned y) {
+                Point row[4];
+                T row_weights[4];
+                collapse_v(basis_v[y], row, row_weights);
+
+                for (unsigned x = 0; x < num_u; ++x)
+                {
+                    out(x, y, project(row, row_weights, basis_u[x]));
+                }
+            };
+
+            parallel_for(0, num_v, sample_row, detail::rows_per_thread(num_u));
+        }
+
+        // Row major, 'out' must hold num_u * num_v points.
+        void sample_grid(unsigned num_u,
+                         unsigned num_v,
+                         Point* out) const
+        {
+            sample_grid(num_u, num_v, [out, num_u](unsigned x, unsigned y, const Point& p) {
+                out[x + y * num_u] = p;
+            });
+        }
+
         const auto& get_points() const
         {
             return points_;
         }
 
+        const auto& get_weights() const
+        {
+            return weights_;
+        }
+
     private:
+        void collapse_v(const std::array<T, 4>& bv, Point* row, T* row_weights) const
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                row[i] = weighted_points_[i] * bv[0] + weighted_points_[i + 4] * bv[1] + weighted_points_[i + 8] * bv[2] + weighted_points_[i + 12] * bv[3];
+                row_weights[i] = weights_[i] * bv[0] + weights_[i + 4] * bv[1] + weights_[i + 8] * bv[2] + weights_[i + 12] * bv[3];
+            }
+        }
+
+        static Point project(const Point* row, const T* row_weights, const std::array<T, 4>& bu)
+        {
+            const T w = row_weights[0] * bu[0] + row_weights[1] * bu[1] + row_weights[2] * bu[2] + row_weights[3] * bu[3];
+            return (row[0] * bu[0] + row[1] * bu[1] + row[2] * bu[2] + row[3] * bu[3]) / w;
+        }
+
         std::array<Point, 4 * 4> points_;
+        std::array<T, 4 * 4> weights_;
+        std::array<Point, 4 * 4> weighted_points_;
     };
 
 } // namespace kgfx
@@ -0,0 +1,252 @@
+#pragma once
+#include "bezier.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace kgfx {
+
+    namespace detail {
+
+        // Lanes of one 256 bit vector register: 8 floats or 4 doubles.
+        template <typename T>
+        constexpr int simd_lanes = static_cast<int>(32 / sizeof(T));
+
+        // Bernstein basis of one lane block, basis[k][lane].
+        template <int degree, typename T, int lanes>
+        inline void bernstein_lanes(const T (&t)[lanes], T (&basis)[degree + 1][lanes])
+        {
+            T t_power[degree + 1][lanes];
+            T s_power[degree + 1][lanes];
+            for (int l = 0; l < lanes; ++l)
+            {
+                t_power[0][l] = T(1);
+                s_power[0][l] = T(1);
+            }
+
+            for (int k = 1; k <= degree; ++k)
+            {
+                for (int l = 0; l < lanes; ++l)
+                {
+                    t_power[k][l] = t_power[k - 1][l] * t[l];
+                    s_power[k][l] = s_power[k - 1][l] * (T(1) - t[l]);
+                }
+            }
+
+            for (int k = 0; k <= degree; ++k)
+            {
+                const T c = static_cast<T>(binomial(degree, k));
+                for (int l = 0; l < lanes; ++l)
+                {
+                    basis[k][l] = c * t_power[k][l] * s_power[degree - k][l];
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // Many rational 3D curves with the same number of control points, stored
+    // structure of arrays: one array per control point and coordinate, the
+    // curves running along it. Evaluation works on blocks of
+    // detail::simd_lanes<T> curves with plain fixed width loops, which the
+    // compiler turns into 4 or 8 wide vector code, no intrinsics needed.
+    //
+    // 'degree' counts control points, like Bezier_curve.
+    template <typename T, int degree>
+    class Bezier_curve_batch {
+    public:
+        static constexpr int lanes = detail::simd_lanes<T>;
+
+        Bezier_curve_batch() = default;
+
+    public:
+        // Returns the index of the added curve.
+        template <typename Point>
+        std::size_t add(const Bezier_curve<Point, T, degree>& curve)
+        {
+            const std::size_t index = size_;
+            resize(size_ + 1);
+
+            const auto& points = curve.get_points();
+            const auto& weights = curve.get_weights();
+            for (int k = 0; k < degree; ++k)
+            {
+                x_[k][index] = points[k].x * weights[k];
+                y_[k][index] = points[k].y * weights[k];
+                z_[k][index] = points[k].z * weights[k];
+                w_[k][index] = weights[k];
+            }
+
+            return index;
+        }
+
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        void clear()
+        {
+            resize(0);
+        }
+
+        // Curve i at parameter t[i], for every curve.
+        void evaluate(const T* t, T* x, T* y, T* z) const
+        {
+            for (std::size_t base = 0; base < size_; base += lanes)
+            {
+                const int width = static_cast<int>(std::min<std::size_t>(lanes, size_ - base));
+
+                T block[lanes];
+                for (int l = 0; l < lanes; ++l)
+                {
+                    block[l] = l < width ? t[base + l] : T(0);
+                }
+
+                evaluate_block(base, block, x + base, y + base, z + base, width);
+            }
+        }
+
+        template <typename Point>
+        void evaluate(const T* t, Point* out) const
+        {
+            T x[lanes];
+            T y[lanes];
+            T z[lanes];
+            for (std::size_t base = 0; base < size_; base += lanes)
+            {
+                const int width = static_cast<int>(std::min<std::size_t>(lanes, size_ - base));
+
+                T block[lanes];
+                for (int l = 0; l < lanes; ++l)
+                {
+                    block[l] = l < width ? t[base + l] : T(0);
+                }
+
+                evaluate_block(base, block, x, y, z, width);
+                for (int l = 0; l < width; ++l)
+                {
+                    out[base + l] = Point(x[l], y[l], z[l]);
+                }
+            }
+        }
+
+        // One curve at 'count' parameters; the lanes run over the parameters.
+        void evaluate(std::size_t curve, const T* t, T* x, T* y, T* z, std::size_t count) const
+        {
+            assert(curve < size_);
+
+            T basis[degree][lanes];
+            for (std::size_t base = 0; base < count; base += lanes)
+            {
+                const int width = static_cast<int>(std::min<std::size_t>(lanes, count - base));
+
+                T block[lanes];
+                for (int l = 0; l < lanes; ++l)
+                {
+                    block[l] = l < width ? t[base + l] : T(0);
+                }
+
+                detail::bernstein_lanes<degree - 1>(block, basis);
+
+                T sx[lanes] = {};
+                T sy[lanes] = {};
+                T sz[lanes] = {};
+                T sw[lanes] = {};
+                for (int k = 0; k < degree; ++k)
+                {
+                    const T px = x_[k][curve];
+                    const T py = y_[k][curve];
+                    const T pz = z_[k][curve];
+                    const T pw = w_[k][curve];
+                    for (int l = 0; l < lanes; ++l)
+                    {
+                        sx[l] += px * basis[k][l];
+                        sy[l] += py * basis[k][l];
+                        sz[l] += pz * basis[k][l];
+                        sw[l] += pw * basis[k][l];
+                    }
+                }
+
+                store(sx, sy, sz, sw, x + base, y + base, z + base, width);
+            }
+        }
+
+    private:
+        void resize(std::size_t size)
+        {
+            // Padded to whole lane blocks so the last block reads valid memory.
+            const std::size_t padded = (size + lanes - 1) / lanes * lanes;
+            for (int k = 0; k < degree; ++k)
+            {
+                x_[k].resize(padded, T(0));
+                y_[k].resize(padded, T(0));
+                z_[k].resize(padded, T(0));
+                w_[k].resize(padded, T(1));
+            }
+
+            size_ = size;
+        }
+
+        void evaluate_block(std::size_t base, const T (&t)[lanes], T* x, T* y, T* z, int width) const
+        {
+            T basis[degree][lanes];
+            detail::bernstein_lanes<degree - 1>(t, basis);
+
+            T sx[lanes] = {};
+            T sy[lanes] = {};
+            T sz[lanes] = {};
+            T sw[lanes] = {};
+            for (int k = 0; k < degree; ++k)
+            {
+                const T* px = &x_[k][base];
+                const T* py = &y_[k][base];
+                const T* pz = &z_[k][base];
+                const T* pw = &w_[k][base];
+                for (int l = 0; l < lanes; ++l)
+                {
+                    sx[l] += px[l] * basis[k][l];
+                    sy[l] += py[l] * basis[k][l];
+                    sz[l] += pz[l] * basis[k][l];
+                    sw[l] += pw[l] * basis[k][l];
+                }
+            }
+
+            store(sx, sy, sz, sw, x, y, z, width);
+        }
+
+        static void store(const T (&sx)[lanes],
+                          const T (&sy)[lanes],
+                          const T (&sz)[lanes],
+                          const T (&sw)[lanes],
+                          T* x,
+                          T* y,
+                          T* z,
+                          int width)
+        {
+            T rx[lanes];
+            T ry[lanes];
+            T rz[lanes];
+            for (int l = 0; l < lanes; ++l)
+            {
+                const T inverse = T(1) / sw[l];
+                rx[l] = sx[l] * inverse;
+                ry[l] = sy[l] * inverse;
+                rz[l] = sz[l] * inverse;
+            }
+
+            std::copy(rx, rx + width, x);
+            std::copy(ry, ry + width, y);
+            std::copy(rz, rz + width, z);
+        }
+
+        std::array<std::vector<T>, degree> x_;
+        std::array<std::vector<T>, degree> y_;
+        std::array<std::vector<T>, degree> z_;
+        std::array<std::vector<T>, degree> w_;
+        std::size_t size_{0};
+    };
+
+} // namespace kgfx
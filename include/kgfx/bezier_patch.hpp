@@ -1,33 +1,369 @@
 #pragma once
+#include "bezier.hpp"
 #include "mesh.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <map>
+#include <vector>
 
-namespace graphics {
-namespace bezier {
-
-	template <typename Mesh>
-	void triangulate_patch(	Mesh& mesh, 
-							const Patch& patch, 
-							unsigned num_samples_x, 
-							unsigned num_samples_y)
-	{
-		mesh.vertices.reserve(num_samples_x*num_samples_y);
-		mesh.triangles.reserve(num_samples_x*num_samples_y*2);
-
-		const float dx = 1.0f/static_cast<float>(num_samples_x);
-		const float dy = 1.0f/static_cast<float>(num_samples_y);
-
-		float ty = 0.0f;
-		for (unsigned y = 0; y < num_samples_y + 1; ++y)
-		{
-			float tx = 0.0f;
-			for (unsigned x = 0; x < num_samples_x + 1; ++x)
-			{
-				tx += dx; 
-			}
-
-			ty += dy;
-		} 
-	}
-
-}
-}
+namespace kgfx {
+
+    // Bicubic patches sharing control points by index, the way patch models
+    // such as the Utah teapot are stored. Patch control points are indexed
+    // row by row, like Bezier_patch.
+    template <typename Point, typename T>
+    class Bezier_patch_set {
+    public:
+        using Patch_indices = std::array<unsigned, 4 * 4>;
+
+        Bezier_patch_set() = default;
+
+        Bezier_patch_set(std::vector<Point> control_points,
+                         std::vector<Patch_indices> patches)
+            : control_points_(std::move(control_points))
+            , patches_(std::move(patches))
+        {
+        }
+
+    public:
+        unsigned add_control_point(const Point& point)
+        {
+            control_points_.push_back(point);
+            return static_cast<unsigned>(control_points_.size() - 1);
+        }
+
+        void add_patch(const Patch_indices& indices)
+        {
+            patches_.push_back(indices);
+        }
+
+    public:
+        std::size_t num_patches() const
+        {
+            return patches_.size();
+        }
+
+        Bezier_patch<Point, T> patch(std::size_t i) const
+        {
+            std::array<Point, 4 * 4> points;
+            for (int k = 0; k < 4 * 4; ++k)
+            {
+                points[k] = control_points_[patches_[i][k]];
+            }
+
+            return Bezier_patch<Point, T>(points);
+        }
+
+        const std::vector<Point>& control_points() const
+        {
+            return control_points_;
+        }
+
+        const std::vector<Patch_indices>& patches() const
+        {
+            return patches_;
+        }
+
+    private:
+        std::vector<Point> control_points_;
+        std::vector<Patch_indices> patches_;
+    };
+
+    // Generator (see mesh_generator.hpp) tessellating a whole patch set with
+    // 'num_segments' per patch edge into one indexed mesh.
+    //
+    // Patches meeting at a corner or along an edge reference the same control
+    // points, so the border vertices are allocated once per corner and once per
+    // edge up front, and every patch indexes those shared vertices instead of
+    // emitting its own copies. No welding pass afterwards. Edges and patches
+    // are then evaluated in parallel, each writing a disjoint vertex range.
+    template <typename Point, typename T>
+    class Patch_set_generator {
+    public:
+        Patch_set_generator(const Bezier_patch_set<Point, T>& patch_set,
+                            unsigned num_segments,
+                            Patch_normals normals = Patch_normals::none)
+            : patch_set_(patch_set)
+            , num_segments_(num_segments)
+            , normals_(normals)
+        {
+            assert(num_segments > 0);
+            build_topology();
+        }
+
+    public:
+        Mesh_size size() const
+        {
+            const std::size_t n = num_segments_;
+
+            Mesh_size s;
+            s.num_vertices = corners_.size() + num_edge_vertices_ + patch_set_.num_patches() * (n - 1) * (n - 1);
+            s.num_triangles = patch_set_.num_patches() * n * n * 2;
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            const unsigned n = num_segments_;
+            const T last = static_cast<T>(n);
+
+            auto write_vertex = [this, vertices](unsigned index, const Bezier_patch<Point, T>& patch, const Point& position, T u, T v) {
+                Vertex vertex{};
+                vertex.position = position;
+                if (normals_ == Patch_normals::analytic)
+                {
+                    set_normal(vertex, patch.normal(u, v));
+                }
+                vertices[index] = vertex;
+            };
+
+            // Corners are the control points themselves.
+            for (std::size_t c = 0; c < corners_.size(); ++c)
+            {
+                const Use& use = corners_[c].first_use;
+                write_vertex(static_cast<unsigned>(c),
+                             patch_set_.patch(use.patch),
+                             patch_set_.control_points()[corners_[c].control_point],
+                             corner_parameters[use.side][0],
+                             corner_parameters[use.side][1]);
+            }
+
+            // Edge interiors, from the boundary curve in its canonical direction.
+            parallel_for(0, static_cast<unsigned>(edges_.size()), [&](unsigned e) {
+                const Edge& edge = edges_[e];
+                if (edge.collapsed)
+                {
+                    return;
+                }
+
+                const auto patch = patch_set_.patch(edge.first_use.patch);
+
+                Point curve[4];
+                for (int i = 0; i < 4; ++i)
+                {
+                    curve[i] = patch_set_.control_points()[edge.key[i]];
+                }
+
+                for (unsigned k = 1; k < n; ++k)
+                {
+                    // Parameter along the first patch's own edge direction.
+                    const T t = static_cast<T>(edge.first_use.reversed ? n - k : k) / last;
+                    write_vertex(edge.first_vertex + k - 1,
+                                 patch,
+                                 detail::sample<3>(curve, static_cast<T>(k) / last),
+                                 edge_parameter(edge.first_use.side, t, 0),
+                                 edge_parameter(edge.first_use.side, t, 1));
+                }
+            }, 16);
+
+            // Patch interiors and triangles. Each task samples its patch's
+            // (n - 1)^2 interior itself, one row of the net collapsed per v,
+            // from basis tables shared by all patches; the border is already
+            // written and patches are parallelism enough.
+            const auto basis = detail::bernstein_table<3, T>(n + 1);
+
+            parallel_for(0, static_cast<unsigned>(patch_set_.num_patches()), [&](unsigned p) {
+                const auto patch = patch_set_.patch(p);
+                const auto& points = patch.get_points();
+                const unsigned interior_base = interior_base_ + p * (n - 1) * (n - 1);
+
+                for (unsigned y = 1; y < n; ++y)
+                {
+                    const auto& bv = basis[y];
+
+                    Point row[4];
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        row[i] = points[i] * bv[0] + points[i + 4] * bv[1] + points[i + 8] * bv[2] + points[i + 12] * bv[3];
+                    }
+
+                    for (unsigned x = 1; x < n; ++x)
+                    {
+                        const auto& bu = basis[x];
+                        write_vertex(interior_base + (x - 1) + (y - 1) * (n - 1),
+                                     patch,
+                                     row[0] * bu[0] + row[1] * bu[1] + row[2] * bu[2] + row[3] * bu[3],
+                                     static_cast<T>(x) / last,
+                                     static_cast<T>(y) / last);
+                    }
+                }
+
+                auto index = [&](unsigned x, unsigned y) {
+                    return base_vertex + vertex_index(p, x, y);
+                };
+
+                Triangle* out = triangles + p * n * n * 2;
+                for (unsigned y = 0; y < n; ++y)
+                {
+                    for (unsigned x = 0; x < n; ++x)
+                    {
+                        *out++ = Triangle(index(x, y), index(x + 1, y), index(x + 1, y + 1));
+                        *out++ = Triangle(index(x + 1, y + 1), index(x, y + 1), index(x, y));
+                    }
+                }
+            }, 4);
+        }
+
+    private:
+        // Where a corner or edge is first seen: patch, side (see
+        // detail::patch_edges) and whether the side runs against the
+        // canonical edge direction.
+        struct Use {
+            std::size_t patch{0};
+            int side{0};
+            bool reversed{false};
+        };
+
+        struct Corner {
+            unsigned control_point{0};
+            Use first_use;
+        };
+
+        struct Edge {
+            std::array<unsigned, 4> key;
+            unsigned first_vertex{0};
+            bool collapsed{false};
+            Use first_use;
+        };
+
+        // Parameter values of the first corner of each side.
+        static constexpr T corner_parameters[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+        static T edge_parameter(int side, T t, int coordinate)
+        {
+            const T start = corner_parameters[side][coordinate];
+            const T end = corner_parameters[(side + 1) % 4][coordinate];
+            return start + (end - start) * t;
+        }
+
+        template <typename Vertex>
+        static void set_normal(Vertex& vertex, const Point& normal)
+        {
+            vertex.normal = normal;
+        }
+
+        void build_topology()
+        {
+            std::map<unsigned, unsigned> corner_ids;
+            std::map<std::array<unsigned, 4>, unsigned> edge_ids;
+
+            const auto& patches = patch_set_.patches();
+            patch_corners_.resize(patches.size());
+            patch_edges_.resize(patches.size());
+
+            for (std::size_t p = 0; p < patches.size(); ++p)
+            {
+                for (int side = 0; side < 4; ++side)
+                {
+                    const int* e = detail::patch_edges[side];
+                    std::array<unsigned, 4> key = {{patches[p][e[0]], patches[p][e[1]], patches[p][e[2]], patches[p][e[3]]}};
+
+                    // Corner at the start of this side.
+                    auto corner = corner_ids.emplace(key[0], static_cast<unsigned>(corners_.size()));
+                    if (corner.second)
+                    {
+                        Corner c;
+                        c.control_point = key[0];
+                        c.first_use.patch = p;
+                        c.first_use.side = side;
+                        corners_.push_back(c);
+                    }
+                    patch_corners_[p][side] = corner.first->second;
+
+                    // Canonical direction: from the smaller control point index.
+                    const bool reversed = key[3] < key[0] || (key[3] == key[0] && key[2] < key[1]);
+                    if (reversed)
+                    {
+                        std::swap(key[0], key[3]);
+                        std::swap(key[1], key[2]);
+                    }
+
+                    auto edge = edge_ids.emplace(key, static_cast<unsigned>(edges_.size()));
+                    if (edge.second)
+                    {
+                        Edge ed;
+                        ed.key = key;
+                        ed.collapsed = key[0] == key[1] && key[1] == key[2] && key[2] == key[3];
+                        ed.first_use.patch = p;
+                        ed.first_use.side = side;
+                        ed.first_use.reversed = reversed;
+                        edges_.push_back(ed);
+                    }
+                    patch_edges_[p][side] = Side{edge.first->second, reversed};
+                }
+            }
+
+            // Vertex ranges: corners, then edge interiors, then patch interiors.
+            unsigned next_vertex = static_cast<unsigned>(corners_.size());
+            for (auto& edge : edges_)
+            {
+                edge.first_vertex = next_vertex;
+                if (!edge.collapsed)
+                {
+                    next_vertex += num_segments_ - 1;
+                }
+            }
+
+            num_edge_vertices_ = next_vertex - static_cast<unsigned>(corners_.size());
+            interior_base_ = next_vertex;
+        }
+
+        // Vertex of grid sample (x, y) in patch 'p', relative to base_vertex.
+        unsigned vertex_index(std::size_t p, unsigned x, unsigned y) const
+        {
+            const unsigned n = num_segments_;
+
+            if (x > 0 && y > 0 && x < n && y < n)
+            {
+                return interior_base_ + static_cast<unsigned>(p) * (n - 1) * (n - 1) + (x - 1) + (y - 1) * (n - 1);
+            }
+
+            // Border: find the side and the distance along it.
+            int side = 0;
+            unsigned k = 0;
+            if (y == 0 && x < n) {
+                side = 0; k = x;
+            } else if (x == n && y < n) {
+                side = 1; k = y;
+            } else if (y == n && x > 0) {
+                side = 2; k = n - x;
+            } else {
+                side = 3; k = n - y;
+            }
+
+            if (k == 0)
+            {
+                return patch_corners_[p][side];
+            }
+
+            const Side& s = patch_edges_[p][side];
+            const Edge& edge = edges_[s.edge];
+            if (edge.collapsed)
+            {
+                return patch_corners_[p][side];
+            }
+
+            return edge.first_vertex + (s.reversed ? n - k : k) - 1;
+        }
+
+        struct Side {
+            unsigned edge{0};
+            bool reversed{false};
+        };
+
+        const Bezier_patch_set<Point, T>& patch_set_;
+        unsigned num_segments_;
+        Patch_normals normals_;
+
+        std::vector<Corner> corners_;
+        std::vector<Edge> edges_;
+        std::vector<std::array<unsigned, 4>> patch_corners_;
+        std::vector<std::array<Side, 4>> patch_edges_;
+        unsigned num_edge_vertices_{0};
+        unsigned interior_base_{0};
+    };
+
+} // namespace kgfx
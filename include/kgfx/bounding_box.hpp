@@ -0,0 +1,119 @@
+#pragma once
+#include "my_glm.hpp"
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+namespace kgfx {
+
+    // Axis aligned box.
+    template <typename Point>
+    struct Bounding_box {
+
+        Bounding_box() = default;
+
+        explicit Bounding_box(const Point& p)
+            : min(p)
+            , max(p)
+        {
+        }
+
+        Bounding_box(const Point& a, const Point& b)
+            : min(glm::min(a, b))
+            , max(glm::max(a, b))
+        {
+        }
+
+        Point min;
+        Point max;
+
+        //
+        void extend(const Point& p)
+        {
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+
+        //
+        void extend(const Bounding_box& other)
+        {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        Point center() const
+        {
+            return (min + max) / typename Point::value_type(2);
+        }
+
+        Point size() const
+        {
+            return max - min;
+        }
+
+        bool contains(const Point& p) const
+        {
+            return glm::min(p, min) == min && glm::max(p, max) == max;
+        }
+
+        bool overlaps(const Bounding_box& other) const
+        {
+            const Point lower = glm::max(min, other.min);
+            const Point upper = glm::min(max, other.max);
+            return glm::min(lower, upper) == lower;
+        }
+    };
+
+    // Bounding box of a non-empty range of points.
+    template <typename Iterator>
+    auto bounding_box(Iterator first, Iterator last)
+    {
+        Bounding_box<std::decay_t<decltype(*first)>> box(*first);
+        for (++first; first != last; ++first)
+        {
+            box.extend(*first);
+        }
+
+        return box;
+    }
+
+    //
+    template <typename Point>
+    struct Ray {
+        Point origin;
+        Point direction;
+    };
+
+    // Slab test. Narrows [t_near, t_far] to the part of the ray inside the box,
+    // false if nothing is left.
+    template <typename Point, typename T>
+    bool intersect(const Ray<Point>& ray, const Bounding_box<Point>& box, T& t_near, T& t_far)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (ray.direction[i] == T(0))
+            {
+                if (ray.origin[i] < box.min[i] || ray.origin[i] > box.max[i]) {
+                    return false;
+                }
+                continue;
+            }
+
+            const T inverse = T(1) / ray.direction[i];
+            T t0 = (box.min[i] - ray.origin[i]) * inverse;
+            T t1 = (box.max[i] - ray.origin[i]) * inverse;
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+
+            t_near = std::max(t_near, t0);
+            t_far = std::min(t_far, t1);
+            if (t_near > t_far) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+} // namespace kgfx
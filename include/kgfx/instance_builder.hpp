@@ -0,0 +1,85 @@
+#pragma once
+#include "my_glm.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace kgfx {
+
+    // Per-instance attributes of instanced draws.
+    struct Instance {
+        glm::mat4 transform{1.0f};
+        glm::vec3 color{1.0f};
+    };
+
+    // Collects instances for one instanced draw, from any number of threads.
+    //
+    // Storage is allocated up front; allocate() hands out disjoint slices
+    // with one compare and swap, so workers (culling, animation) fill their own
+    // slices without locking. Not thread safe against clear().
+    class Instance_builder {
+    public:
+        explicit Instance_builder(std::size_t capacity)
+            : instances_(capacity)
+        {
+        }
+
+        Instance_builder(const Instance_builder&) = delete;
+        Instance_builder& operator=(const Instance_builder&) = delete;
+
+    public:
+        // 'count' consecutive instances for the caller to fill, null when
+        // full.
+        Instance* allocate(std::size_t count)
+        {
+            std::size_t first = size_.load(std::memory_order_relaxed);
+            do
+            {
+                if (first + count > instances_.size()) {
+                    return nullptr;
+                }
+            } while (!size_.compare_exchange_weak(first, first + count, std::memory_order_relaxed));
+
+            return &instances_[first];
+        }
+
+        bool push_back(const Instance& instance)
+        {
+            Instance* slot = allocate(1);
+            if (nullptr == slot) {
+                return false;
+            }
+
+            *slot = instance;
+            return true;
+        }
+
+        void clear()
+        {
+            size_.store(0, std::memory_order_relaxed);
+        }
+
+    public:
+        // Call once the workers are done (joined), not concurrently with them.
+        const Instance* data() const
+        {
+            return instances_.data();
+        }
+
+        std::size_t size() const
+        {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        std::size_t capacity() const
+        {
+            return instances_.size();
+        }
+
+    private:
+        std::vector<Instance> instances_;
+        std::atomic<std::size_t> size_{0};
+    };
+
+} // namespace kgfx
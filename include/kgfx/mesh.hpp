@@ -1,5 +1,8 @@
 #pragma once
 #include "my_glm.hpp"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace kgfx {
@@ -78,6 +81,191 @@ namespace kgfx {
 
     typedef std::vector<Triangle> Triangle_array;
 
+    // Number of vertices and triangles a mesh generator writes. Known before
+    // generation so the output storage can be sized (or mapped) up front.
+    struct Mesh_size {
+        std::size_t num_vertices{0};
+        std::size_t num_triangles{0};
+    };
+
+    // Writes the (num_x - 1) * (num_y - 1) * 2 triangles of a regular vertex grid.
+    inline Triangle* write_grid_triangles(Triangle* out,
+                                          unsigned num_x,
+                                          unsigned num_y,
+                                          unsigned base_vertex)
+    {
+        for (unsigned y = 0; y + 1 < num_y; ++y)
+        {
+            for (unsigned x = 0; x + 1 < num_x; ++x)
+            {
+                const unsigned v0 = base_vertex + x + y * num_x;
+                *out++ = Triangle(v0, v0 + 1, v0 + 1 + num_x);
+                *out++ = Triangle(v0 + 1 + num_x, v0 + num_x, v0);
+            }
+        }
+
+        return out;
+    }
+
+    namespace detail {
+
+        struct Ignore_sample {
+            template <typename... Point>
+            void operator()(unsigned, unsigned, const Point&...) const
+            {
+            }
+        };
+
+        template <typename Patch, typename = void>
+        struct Has_sample_grid : std::false_type {
+        };
+
+        template <typename Patch>
+        struct Has_sample_grid<Patch,
+                               std::void_t<decltype(std::declval<const Patch&>().sample_grid(
+                                   1u, 1u, Ignore_sample()))>>
+            : std::true_type {
+        };
+
+        template <typename Patch, typename = void>
+        struct Has_sample_grid_forward : std::false_type {
+        };
+
+        template <typename Patch>
+        struct Has_sample_grid_forward<Patch,
+                                       std::void_t<decltype(std::declval<const Patch&>().sample_grid_forward(
+                                           1u, 1u, Ignore_sample()))>>
+            : std::true_type {
+        };
+
+        template <typename Patch, typename = void>
+        struct Has_sample_grid_normals : std::false_type {
+        };
+
+        template <typename Patch>
+        struct Has_sample_grid_normals<Patch,
+                                       std::void_t<decltype(std::declval<const Patch&>().sample_grid_normals(
+                                           1u, 1u, Ignore_sample()))>>
+            : std::true_type {
+        };
+
+    } // namespace detail
+
+    // How Patch_generator evaluates the patch. Falls back to sampling each
+    // vertex with 'sample(tx, ty)' when the patch lacks the grid function.
+    enum class Patch_sampling {
+        basis_tables,       // sample_grid
+        forward_differences // sample_grid_forward
+    };
+
+    // Vertex normals written by Patch_generator. 'analytic' needs a patch
+    // with 'sample_grid_normals' and evaluates positions with basis tables.
+    enum class Patch_normals {
+        none,    // Left zero, see Triangle_mesh::calculate_vertex_normals.
+        analytic // Exact surface normal, same pass as the position.
+    };
+
+    // Generator for a regular grid of patch samples. Any type with
+    // 'sample(tx, ty)' will do as patch.
+    template <typename Patch>
+    class Patch_generator {
+    public:
+        Patch_generator(const Patch& patch,
+                        unsigned num_samples_x,
+                        unsigned num_samples_y,
+                        Patch_sampling sampling = Patch_sampling::basis_tables,
+                        Patch_normals normals = Patch_normals::none)
+            : patch_(patch)
+            , num_samples_x_(num_samples_x)
+            , num_samples_y_(num_samples_y)
+            , sampling_(sampling)
+            , normals_(normals)
+        {
+            assert(num_samples_x > 1 && num_samples_y > 1);
+        }
+
+    public:
+        Mesh_size size() const
+        {
+            Mesh_size s;
+            s.num_vertices = num_samples_x_ * num_samples_y_;
+            s.num_triangles = (num_samples_x_ - 1) * (num_samples_y_ - 1) * 2;
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            write_grid_triangles(triangles, num_samples_x_, num_samples_y_, base_vertex);
+
+            const unsigned num_x = num_samples_x_;
+            auto write_vertex = [vertices, num_x](unsigned x, unsigned y, const auto& position) {
+                Vertex v{};
+                v.position = position;
+                vertices[x + y * num_x] = v;
+            };
+
+            if constexpr (detail::Has_sample_grid_normals<Patch>::value)
+            {
+                if (normals_ == Patch_normals::analytic)
+                {
+                    patch_.sample_grid_normals(num_samples_x_,
+                                               num_samples_y_,
+                                               [vertices, num_x](unsigned x, unsigned y, const auto& position, const auto& normal) {
+                                                   Vertex v{};
+                                                   v.position = position;
+                                                   v.normal = normal;
+                                                   vertices[x + y * num_x] = v;
+                                               });
+                    return;
+                }
+            }
+            else
+            {
+                assert(normals_ == Patch_normals::none && "Patch type cannot provide analytic normals.");
+            }
+
+            if constexpr (detail::Has_sample_grid_forward<Patch>::value)
+            {
+                if (sampling_ == Patch_sampling::forward_differences)
+                {
+                    patch_.sample_grid_forward(num_samples_x_, num_samples_y_, write_vertex);
+                    return;
+                }
+            }
+
+            if constexpr (detail::Has_sample_grid<Patch>::value)
+            {
+                patch_.sample_grid(num_samples_x_, num_samples_y_, write_vertex);
+            }
+            else
+            {
+                const float dx = 1.0f / static_cast<float>(num_samples_x_ - 1);
+                const float dy = 1.0f / static_cast<float>(num_samples_y_ - 1);
+
+                for (unsigned y = 0; y < num_samples_y_; ++y)
+                {
+                    const float ty = static_cast<float>(y) * dy;
+                    for (unsigned x = 0; x < num_samples_x_; ++x)
+                    {
+                        Vertex v{};
+                        v.position = patch_.sample(static_cast<float>(x) * dx, ty);
+                        *vertices++ = v;
+                    }
+                }
+            }
+        }
+
+    private:
+        const Patch& patch_;
+        unsigned num_samples_x_;
+        unsigned num_samples_y_;
+        Patch_sampling sampling_;
+        Patch_normals normals_;
+    };
+
     //
     template <typename Vertex = kgfx::Vertex>
     struct Triangle_mesh {
@@ -276,46 +464,36 @@ namespace kgfx {
         }
 
     public:
-        //
-        template <typename Patch>
-        void make_patch(const Patch& patch,
-                        unsigned num_samples_x,
-                        unsigned num_samples_y)
+        // Appends the output of a generator (see mesh_generator.hpp). Storage is
+        // sized up front, so nothing is reallocated while the generator runs;
+        // resizing value-initializes the new elements before the generator
+        // overwrites them. Only mapped GL storage (opengl::Mesh::load_generated)
+        // has every vertex written exactly once.
+        template <typename Generator>
+        void generate(const Generator& generator)
         {
-            // Triangles.
-            const size_t triangle_offset = vertices.size();
-            triangles.reserve(triangle_offset + num_samples_x * num_samples_y * 2);
-            for (unsigned y = 0; y < num_samples_y - 1; ++y)
-            {
-                for (unsigned x = 0; x < num_samples_x - 1; ++x)
-                {
-                    const unsigned v0 = triangle_offset + x + y * num_samples_x;
-                    triangles.push_back({v0, v0 + 1, v0 + 1 + num_samples_x});
-                    triangles.push_back({v0 + 1 + num_samples_x, v0 + num_samples_x, v0});
-                }
-            }
+            const Mesh_size size = generator.size();
 
-            // Vertices.
-            vertices.reserve(vertices.size() + num_samples_x * num_samples_y);
+            const std::size_t first_vertex = vertices.size();
+            const std::size_t first_triangle = triangles.size();
 
-            const float dx = 1.0f / static_cast<float>(num_samples_x - 1);
-            const float dy = 1.0f / static_cast<float>(num_samples_y - 1);
+            vertices.resize(first_vertex + size.num_vertices);
+            triangles.resize(first_triangle + size.num_triangles);
 
-            float ty = 0.0f;
-            for (unsigned y = 0; y < num_samples_y; ++y)
-            {
-                float tx = 0.0f;
-                for (unsigned x = 0; x < num_samples_x; ++x)
-                {
-                    Vertex v;
-                    v.position = patch.sample(tx, ty);
-                    vertices.push_back(v);
-
-                    tx += dx;
-                }
+            generator.generate(vertices.data() + first_vertex,
+                               triangles.data() + first_triangle,
+                               static_cast<unsigned>(first_vertex));
+        }
 
-                ty += dy;
-            }
+        //
+        template <typename Patch>
+        void make_patch(const Patch& patch,
+                        unsigned num_samples_x,
+                        unsigned num_samples_y,
+                        Patch_sampling sampling = Patch_sampling::basis_tables,
+                        Patch_normals normals = Patch_normals::none)
+        {
+            generate(Patch_generator<Patch>(patch, num_samples_x, num_samples_y, sampling, normals));
         }
 
     private:
@@ -0,0 +1,190 @@
+#pragma once
+#include "mesh.hpp"
+#include <cmath>
+
+// Procedural mesh generators.
+//
+// A generator reports its Mesh_size before anything is written and then
+// writes vertices and triangles straight into caller supplied storage:
+//
+//     Mesh_size size() const;
+//     template <typename Vertex>
+//     void generate(Vertex* vertices, Triangle* triangles, unsigned base_vertex) const;
+//
+// The storage can be a Triangle_mesh (Triangle_mesh::generate) or a mapped
+// GL buffer (opengl::Mesh::load_generated). Output is written sequentially
+// and never read back, which is what write-combined GPU memory wants.
+
+namespace kgfx {
+
+    // Flat grid in the xz-plane, centered at the origin, facing +y.
+    class Grid_generator {
+    public:
+        Grid_generator(unsigned num_x,
+                       unsigned num_z,
+                       const glm::vec2& extent = glm::vec2(1.0f))
+            : num_x_(num_x)
+            , num_z_(num_z)
+            , extent_(extent)
+        {
+            assert(num_x > 1 && num_z > 1);
+        }
+
+    public:
+        Mesh_size size() const
+        {
+            Mesh_size s;
+            s.num_vertices = num_x_ * num_z_;
+            s.num_triangles = (num_x_ - 1) * (num_z_ - 1) * 2;
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            write_grid_triangles(triangles, num_x_, num_z_, base_vertex);
+
+            const float dx = extent_.x / static_cast<float>(num_x_ - 1);
+            const float dz = extent_.y / static_cast<float>(num_z_ - 1);
+            const glm::vec2 origin(-extent_.x * 0.5f, extent_.y * 0.5f);
+
+            // Rows run towards -z to get clockwise front faces.
+            for (unsigned z = 0; z < num_z_; ++z)
+            {
+                for (unsigned x = 0; x < num_x_; ++x)
+                {
+                    Vertex v{};
+                    v.position = glm::vec3(origin.x + static_cast<float>(x) * dx,
+                                           0.0f,
+                                           origin.y - static_cast<float>(z) * dz);
+                    v.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                    *vertices++ = v;
+                }
+            }
+        }
+
+    private:
+        unsigned num_x_;
+        unsigned num_z_;
+        glm::vec2 extent_;
+    };
+
+    // Axis aligned box centered at the origin. Four vertices per face so
+    // every face gets a flat normal.
+    class Box_generator {
+    public:
+        explicit Box_generator(const glm::vec3& half_extents = glm::vec3(0.5f))
+            : half_extents_(half_extents)
+        {
+        }
+
+    public:
+        Mesh_size size() const
+        {
+            Mesh_size s;
+            s.num_vertices = 6 * 4;
+            s.num_triangles = 6 * 2;
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            // Face normal followed by two tangents with cross(a, b) == normal.
+            static const glm::vec3 faces[6][3] = {
+                {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+                {{-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},
+                {{0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+                {{0.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+                {{0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                {{0.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}};
+
+            for (const auto& face : faces)
+            {
+                triangles = write_grid_triangles(triangles, 2, 2, base_vertex);
+                base_vertex += 4;
+
+                for (float t : {-1.0f, 1.0f})
+                {
+                    for (float s : {-1.0f, 1.0f})
+                    {
+                        Vertex v{};
+                        v.position = (face[0] + face[1] * s + face[2] * t) * half_extents_;
+                        v.normal = face[0];
+                        *vertices++ = v;
+                    }
+                }
+            }
+        }
+
+    private:
+        glm::vec3 half_extents_;
+    };
+
+    // UV sphere centered at the origin. The seam column is duplicated so
+    // the vertex grid stays regular.
+    class Sphere_generator {
+    public:
+        Sphere_generator(float radius,
+                         unsigned num_slices,
+                         unsigned num_stacks)
+            : radius_(radius)
+            , num_slices_(num_slices)
+            , num_stacks_(num_stacks)
+        {
+            assert(num_slices > 2 && num_stacks > 1);
+        }
+
+    public:
+        Mesh_size size() const
+        {
+            Mesh_size s;
+            s.num_vertices = (num_slices_ + 1) * (num_stacks_ + 1);
+            s.num_triangles = num_slices_ * num_stacks_ * 2;
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            write_grid_triangles(triangles, num_slices_ + 1, num_stacks_ + 1, base_vertex);
+
+            const float pi = 3.14159265358979f;
+            const float d_phi = 2.0f * pi / static_cast<float>(num_slices_);
+            const float d_theta = pi / static_cast<float>(num_stacks_);
+
+            // From the south pole and up.
+            for (unsigned stack = 0; stack <= num_stacks_; ++stack)
+            {
+                const float theta = static_cast<float>(stack) * d_theta;
+                const float ring_radius = std::sin(theta);
+                const float y = -std::cos(theta);
+
+                for (unsigned slice = 0; slice <= num_slices_; ++slice)
+                {
+                    const float phi = static_cast<float>(slice) * d_phi;
+                    const glm::vec3 normal(ring_radius * std::cos(phi),
+                                           y,
+                                           -ring_radius * std::sin(phi));
+
+                    Vertex v{};
+                    v.position = normal * radius_;
+                    v.normal = normal;
+                    *vertices++ = v;
+                }
+            }
+        }
+
+    private:
+        float radius_;
+        unsigned num_slices_;
+        unsigned num_stacks_;
+    };
+
+} // namespace kgfx
@@ -0,0 +1,374 @@
+#pragma once
+#include "bounding_box.hpp"
+#include "mesh.hpp"
+#include "my_glm.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace kgfx {
+
+    // Software occlusion culling against a small CPU depth buffer.
+    //
+    // Each frame: clear(), rasterize a few large occluders (walls, floors,
+    // terrain) with add_occluder(), build() the depth hierarchy, then test
+    // instance bounds with is_visible() or cull() before submitting draws.
+    //
+    // Occluders cover the pixels whose centers they cover, at the depth of
+    // their farthest vertex; triangles crossing the near plane are left out.
+    // Boxes crossing the near plane or the buffer's edges are visible. Depth
+    // is window depth, 0 near and 1 far.
+    class Occlusion_culler {
+    public:
+        struct Stats {
+            std::size_t num_occluder_triangles{0};
+            std::size_t num_tested{0};
+            std::size_t num_culled{0};
+            double rasterize_ms{0.0};
+            double test_ms{0.0};
+        };
+
+        Occlusion_culler(int width = 256, int height = 128)
+            : width_(width)
+            , height_(height)
+        {
+            assert(width > 0 && height > 0);
+
+            // Level 0 is the depth buffer, every next level half the size,
+            // down to a single texel.
+            int w = width;
+            int h = height;
+            for (;;)
+            {
+                Level level;
+                level.width = w;
+                level.height = h;
+                level.max.resize(std::size_t(w) * h);
+                levels_.push_back(std::move(level));
+
+                if (w == 1 && h == 1) {
+                    break;
+                }
+
+                w = std::max(1, (w + 1) / 2);
+                h = std::max(1, (h + 1) / 2);
+            }
+
+            clear();
+        }
+
+    public:
+        // Far depth everywhere, and fresh statistics.
+        void clear()
+        {
+            std::fill(depth_begin(), depth_end(), 1.0f);
+            built_ = false;
+            stats_ = Stats();
+        }
+
+        template <typename Vertex>
+        void add_occluder(const Triangle_mesh<Vertex>& mesh, const glm::mat4& model_view_projection)
+        {
+            const auto start = Clock::now();
+
+            screen_.resize(mesh.vertices.size());
+            for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+            {
+                screen_[i] = to_screen(model_view_projection * glm::vec4(mesh.vertices[i].position, 1.0f));
+            }
+
+            for (const auto& triangle : mesh.triangles)
+            {
+                rasterize(screen_[triangle.v0], screen_[triangle.v1], screen_[triangle.v2]);
+            }
+
+            stats_.num_occluder_triangles += mesh.triangles.size();
+            stats_.rasterize_ms += elapsed_ms(start);
+            built_ = false;
+        }
+
+        // Depth hierarchy of what has been rasterized: every texel holds the
+        // farthest depth of the texels it covers in the level below.
+        void build()
+        {
+            const auto start = Clock::now();
+
+            for (std::size_t l = 1; l < levels_.size(); ++l)
+            {
+                const Level& fine = levels_[l - 1];
+                Level& coarse = levels_[l];
+
+                for (int y = 0; y < coarse.height; ++y)
+                {
+                    const int y0 = std::min(2 * y, fine.height - 1);
+                    const int y1 = std::min(2 * y + 1, fine.height - 1);
+
+                    for (int x = 0; x < coarse.width; ++x)
+                    {
+                        const int x0 = std::min(2 * x, fine.width - 1);
+                        const int x1 = std::min(2 * x + 1, fine.width - 1);
+
+                        const std::size_t i00 = std::size_t(y0) * fine.width + x0;
+                        const std::size_t i01 = std::size_t(y0) * fine.width + x1;
+                        const std::size_t i10 = std::size_t(y1) * fine.width + x0;
+                        const std::size_t i11 = std::size_t(y1) * fine.width + x1;
+
+                        const std::size_t i = std::size_t(y) * coarse.width + x;
+                        coarse.max[i] = std::max(std::max(fine.max[i00], fine.max[i01]),
+                                                 std::max(fine.max[i10], fine.max[i11]));
+                    }
+                }
+            }
+
+            built_ = true;
+            stats_.rasterize_ms += elapsed_ms(start);
+        }
+
+        // False when the (world space) box is certainly hidden.
+        bool is_visible(const Bounding_box<glm::vec3>& box, const glm::mat4& view_projection)
+        {
+            assert(built_ && "build() after adding occluders.");
+
+            ++stats_.num_tested;
+            if (is_occluded(box, view_projection))
+            {
+                ++stats_.num_culled;
+                return false;
+            }
+
+            return true;
+        }
+
+        // is_visible() for every box, timed.
+        void cull(const std::vector<Bounding_box<glm::vec3>>& boxes,
+                  const glm::mat4& view_projection,
+                  std::vector<bool>& visible)
+        {
+            const auto start = Clock::now();
+
+            visible.resize(boxes.size());
+            for (std::size_t i = 0; i < boxes.size(); ++i)
+            {
+                visible[i] = is_visible(boxes[i], view_projection);
+            }
+
+            stats_.test_ms += elapsed_ms(start);
+        }
+
+        // Since the last clear().
+        const Stats& stats() const
+        {
+            return stats_;
+        }
+
+    public:
+        int width() const
+        {
+            return width_;
+        }
+
+        int height() const
+        {
+            return height_;
+        }
+
+        // Window depth at pixel (x, y), y up.
+        float depth(int x, int y) const
+        {
+            return levels_[0].max[std::size_t(y) * width_ + x];
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Level {
+            int width{0};
+            int height{0};
+            std::vector<float> max;
+        };
+
+        // Pixel coordinates and window depth; w <= 0 marks points at or
+        // behind the near plane (a small w keeps divisions sane).
+        struct Screen_point {
+            float x;
+            float y;
+            float depth;
+            bool in_front;
+        };
+
+        static double elapsed_ms(Clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        float* depth_begin()
+        {
+            return levels_[0].max.data();
+        }
+
+        float* depth_end()
+        {
+            return levels_[0].max.data() + levels_[0].max.size();
+        }
+
+        Screen_point to_screen(const glm::vec4& clip) const
+        {
+            Screen_point p;
+            p.in_front = clip.w > 1e-5f && clip.z > -clip.w;
+            if (!p.in_front) {
+                p.x = p.y = p.depth = 0.0f;
+                return p;
+            }
+
+            const float inv_w = 1.0f / clip.w;
+            p.x = (clip.x * inv_w * 0.5f + 0.5f) * static_cast<float>(width_);
+            p.y = (clip.y * inv_w * 0.5f + 0.5f) * static_cast<float>(height_);
+            p.depth = clip.z * inv_w * 0.5f + 0.5f;
+            return p;
+        }
+
+        void rasterize(Screen_point a, Screen_point b, Screen_point c)
+        {
+            if (!a.in_front || !b.in_front || !c.in_front) {
+                return;
+            }
+
+            // Counter clockwise, so inside is where every edge function is
+            // positive. Either facing occludes.
+            const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area == 0.0f) {
+                return;
+            }
+
+            if (area < 0.0f) {
+                std::swap(b, c);
+            }
+
+            const float depth = std::max(std::max(a.depth, b.depth), c.depth);
+            if (depth > 1.0f) {
+                return;
+            }
+
+            const int x_begin = std::max(0, static_cast<int>(std::floor(std::min(std::min(a.x, b.x), c.x))));
+            const int x_end = std::min(width_, static_cast<int>(std::ceil(std::max(std::max(a.x, b.x), c.x))));
+            const int y_begin = std::max(0, static_cast<int>(std::floor(std::min(std::min(a.y, b.y), c.y))));
+            const int y_end = std::min(height_, static_cast<int>(std::ceil(std::max(std::max(a.y, b.y), c.y))));
+            if (x_begin >= x_end || y_begin >= y_end) {
+                return;
+            }
+
+            // Edge functions e = dx * x + dy * y + offset, non-negative for all
+            // three at pixel centers inside. Pixels on shared edges are covered
+            // by both triangles, which leaves no cracks in the occluder.
+            struct Edge {
+                float dx;
+                float dy;
+                float offset;
+            };
+
+            auto edge = [](const Screen_point& from, const Screen_point& to) {
+                Edge e;
+                e.dx = from.y - to.y;
+                e.dy = to.x - from.x;
+                e.offset = -(e.dx * from.x + e.dy * from.y);
+                return e;
+            };
+
+            const Edge e0 = edge(a, b);
+            const Edge e1 = edge(b, c);
+            const Edge e2 = edge(c, a);
+
+            float* const buffer = depth_begin();
+            for (int y = y_begin; y < y_end; ++y)
+            {
+                const float py = static_cast<float>(y) + 0.5f;
+                const float row0 = e0.dy * py + e0.offset;
+                const float row1 = e1.dy * py + e1.offset;
+                const float row2 = e2.dy * py + e2.offset;
+
+                // Branch free, so the compiler vectorizes the span.
+                float* const row = buffer + std::size_t(y) * width_;
+                for (int x = x_begin; x < x_end; ++x)
+                {
+                    const float px = static_cast<float>(x) + 0.5f;
+                    const bool inside = (e0.dx * px + row0 >= 0.0f)
+                                        & (e1.dx * px + row1 >= 0.0f)
+                                        & (e2.dx * px + row2 >= 0.0f);
+                    row[x] = inside ? std::min(row[x], depth) : row[x];
+                }
+            }
+        }
+
+        bool is_occluded(const Bounding_box<glm::vec3>& box, const glm::mat4& view_projection) const
+        {
+            float x_min = static_cast<float>(width_);
+            float x_max = 0.0f;
+            float y_min = static_cast<float>(height_);
+            float y_max = 0.0f;
+            float nearest = 1.0f;
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const glm::vec3 p((corner & 1) ? box.max.x : box.min.x,
+                                  (corner & 2) ? box.max.y : box.min.y,
+                                  (corner & 4) ? box.max.z : box.min.z);
+
+                const Screen_point s = to_screen(view_projection * glm::vec4(p, 1.0f));
+                if (!s.in_front) {
+                    return false;
+                }
+
+                x_min = std::min(x_min, s.x);
+                x_max = std::max(x_max, s.x);
+                y_min = std::min(y_min, s.y);
+                y_max = std::max(y_max, s.y);
+                nearest = std::min(nearest, s.depth);
+            }
+
+            // Partly outside the buffer: nothing known about that part.
+            if (x_min < 0.0f || y_min < 0.0f
+                || x_max > static_cast<float>(width_) || y_max > static_cast<float>(height_))
+            {
+                return false;
+            }
+
+            const int x0 = static_cast<int>(x_min);
+            const int x1 = std::min(width_ - 1, static_cast<int>(x_max));
+            const int y0 = static_cast<int>(y_min);
+            const int y1 = std::min(height_ - 1, static_cast<int>(y_max));
+
+            // The level where the rectangle spans at most 2 texels each way,
+            // so at most 3 by 3 texels are read.
+            std::size_t l = 0;
+            while (l + 1 < levels_.size() && std::max(x1 - x0, y1 - y0) >> l >= 2)
+            {
+                ++l;
+            }
+
+            const Level& level = levels_[l];
+            for (int y = y0 >> l; y <= (y1 >> l); ++y)
+            {
+                for (int x = x0 >> l; x <= (x1 >> l); ++x)
+                {
+                    if (nearest <= level.max[std::size_t(y) * level.width + x]) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        int width_;
+        int height_;
+        std::vector<Level> levels_;
+        std::vector<Screen_point> screen_;
+        bool built_{false};
+
+        Stats stats_;
+    };
+
+} // namespace kgfx
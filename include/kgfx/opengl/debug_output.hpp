@@ -0,0 +1,98 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+namespace kgfx {
+namespace opengl {
+
+    struct Debug_message {
+        enum Source { api,
+                      window_system,
+                      shader_compiler,
+                      third_party,
+                      application,
+                      other,
+                      num_sources };
+
+        enum Severity { notification,
+                        low,
+                        medium,
+                        high,
+                        num_severities };
+
+        Source source;
+        Severity severity;
+        GLenum type;
+        GLuint id;
+        const char* text;
+    };
+
+    // Error and performance reports pushed by the driver (KHR_debug, core in
+    // OpenGL 4.3), replacing glGetError polling.
+    //
+    // Messages below 'min_severity' are filtered out by the driver. The rest
+    // are counted by source and severity and passed to the handler, which by
+    // default writes them to stderr. Asynchronous output can call the handler
+    // from a driver thread; synchronous output calls it from inside the
+    // offending GL call, which makes it easy to break on, at some cost.
+    //
+    // Build with KGFX_GL_ERROR_POLLING off to compile out the glGetError
+    // checks after GL calls; this is the error reporting left then. Drivers
+    // may only report to debug contexts, see Renderer's 'debug_context'.
+    class Debug_output
+    {
+    public:
+        using Handler = std::function<void(const Debug_message&)>;
+
+        struct Stats {
+            std::array<std::size_t, Debug_message::num_sources> by_source{};
+            std::array<std::size_t, Debug_message::num_severities> by_severity{};
+            std::size_t errors{0};
+        };
+
+        explicit Debug_output(Debug_message::Severity min_severity = Debug_message::low,
+                              bool synchronous = false);
+        Debug_output(const Debug_output&) = delete;
+
+        ~Debug_output();
+
+        Debug_output& operator=(const Debug_output&) = delete;
+
+    public:
+        // Safe while output is on. The handler runs under a lock, so it
+        // must not call set_handler itself.
+        void set_handler(Handler);
+
+        // Mutes messages by id, for known noise of a particular driver.
+        void ignore(Debug_message::Source source, GLenum type, GLuint id);
+
+        Stats stats() const;
+        void reset_stats();
+
+        static void write_to_stderr(const Debug_message&);
+
+    private:
+        static void GLAPIENTRY callback(GLenum source,
+                                        GLenum type,
+                                        GLuint id,
+                                        GLenum severity,
+                                        GLsizei length,
+                                        const GLchar* message,
+                                        const void* user_param);
+
+        void receive(const Debug_message&);
+
+        Handler handler_{write_to_stderr};
+        std::mutex handler_mutex_;
+
+        std::array<std::atomic<std::size_t>, Debug_message::num_sources> by_source_{};
+        std::array<std::atomic<std::size_t>, Debug_message::num_severities> by_severity_{};
+        std::atomic<std::size_t> errors_{0};
+    };
+
+} // namespace opengl
+} // namespace kgfx
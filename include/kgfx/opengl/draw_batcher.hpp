@@ -0,0 +1,75 @@
+#pragma once
+#include <GL/glew.h>
+#include "mesh_pool.hpp"
+#include "shader.hpp"
+#include "stream_buffer.hpp"
+#include "../my_glm.hpp"
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // Collects the meshes to draw in a frame and submits them with one
+    // glMultiDrawElementsIndirect per (shader, mesh pool) pair.
+    //
+    // Commands and transforms are written into stream buffers. The transforms
+    // of a batch are bound as a shader storage buffer at 'transform_binding',
+    // in command order, so the vertex shader picks its own with the draw id:
+    //
+    //     #extension GL_ARB_shader_draw_parameters : require
+    //     layout(std430, binding = 0) readonly buffer Draw_transforms {
+    //         mat4 transforms[];
+    //     };
+    //     ... transforms[gl_DrawIDARB] ...
+    //
+    // (gl_DrawID in GLSL 4.60.) Each command's base instance is also its draw
+    // index, for shaders reading it from gl_BaseInstanceARB instead.
+    class Draw_batcher
+    {
+    public:
+        static constexpr GLuint transform_binding = 0;
+
+        struct Stats {
+            std::size_t num_draws{0};
+            std::size_t num_batches{0};
+        };
+
+        Draw_batcher(std::size_t max_draws, unsigned num_frames = 3);
+        Draw_batcher(const Draw_batcher&) = delete;
+
+        Draw_batcher& operator=(const Draw_batcher&) = delete;
+
+    public:
+        // The mesh is looked up at render(), so the pool may still move it
+        // (allocate, defragment) in between; it must not be freed.
+        void add(Shader_program& shader,
+                 const Mesh_pool& pool,
+                 Mesh_pool::Mesh_id mesh,
+                 const glm::mat4& transform);
+
+        // Submits everything added since the last call, then clears.
+        void render();
+
+        // Of the last render().
+        const Stats& stats() const;
+
+    private:
+        struct Draw {
+            Shader_program* shader{nullptr};
+            const Mesh_pool* pool{nullptr};
+            Mesh_pool::Mesh_id mesh{0};
+            glm::mat4 transform;
+        };
+
+        std::vector<Draw> draws_;
+        std::size_t max_draws_{0};
+
+        Stream_buffer command_stream_;
+        Stream_buffer transform_stream_;
+        GLsizeiptr storage_alignment_{256};
+
+        Stats stats_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
@@ -0,0 +1,107 @@
+#pragma once
+#include <GL/glew.h>
+#include "../rolling_stat.hpp"
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // CPU and GPU time of named sections of a frame, over the last 'window'
+    // frames.
+    //
+    // GPU time is measured with GL_TIME_ELAPSED queries, a ring of
+    // 'num_queries' per section to cover the frames a driver queues ahead.
+    // Every end_frame() collects the results that have become available, so
+    // reading never waits for the GPU, and a query is only reused once its
+    // result is in. When all of a section's queries are still pending, that
+    // frame's run of the section gets no GPU time; its CPU time is recorded
+    // regardless. Timer queries cannot nest, so neither can sections, and
+    // each section runs at most once per frame.
+    class Frame_profiler
+    {
+    public:
+        using Section = unsigned;
+
+        struct Section_stats {
+            std::string name;
+            Rolling_stat cpu_ms;
+            Rolling_stat gpu_ms;
+        };
+
+        class Scope
+        {
+        private:
+            friend class Frame_profiler;
+
+            Scope(Frame_profiler* profiler, Section section);
+
+        public:
+            Scope(Scope&&) noexcept;
+            Scope(const Scope&) = delete;
+            ~Scope();
+
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Frame_profiler* profiler_{nullptr};
+            Section section_{0};
+        };
+
+        explicit Frame_profiler(std::size_t window = 120);
+        Frame_profiler(const Frame_profiler&) = delete;
+
+        ~Frame_profiler();
+
+        Frame_profiler& operator=(const Frame_profiler&) = delete;
+
+    public:
+        Section add_section(const std::string& name);
+
+        void begin(Section);
+        void end(Section);
+        Scope scope(Section);
+
+        // Records this frame's CPU times and collects the GPU times that have
+        // become available.
+        void end_frame();
+
+        // Deletes the queries, for owners that destroy the context before
+        // the profiler; the next begin() creates new ones. Results still
+        // pending are dropped.
+        void release();
+
+    public:
+        const std::vector<Section_stats>& sections() const;
+
+        // One line per section: average and max, CPU and GPU, in ms.
+        std::string report() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr unsigned num_queries = 4;
+
+        struct Timing {
+            std::array<GLuint, num_queries> queries{};
+            std::array<bool, num_queries> pending{};
+
+            // Slot of the next query to begin, also the oldest one pending.
+            unsigned next{0};
+
+            Clock::time_point cpu_begin;
+            double cpu_ms{0.0};
+            bool active{false};
+            bool gpu_timed{false};
+            bool ran{false};
+        };
+
+        std::size_t window_;
+        std::vector<Section_stats> sections_;
+        std::vector<Timing> timings_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
@@ -0,0 +1,52 @@
+#pragma once
+#include <GL/glew.h>
+#include "../instance_builder.hpp"
+
+namespace kgfx {
+namespace opengl {
+
+    // GPU copy of the instances of an Instance_builder, for
+    // Mesh::render_instanced. Shaders read the transform columns at attribute
+    // locations 3 to 6 and the color at location 7.
+    class Instance_buffer
+    {
+    public:
+        static constexpr GLuint first_attribute = 3;
+
+        Instance_buffer() = default;
+        Instance_buffer(const Instance_buffer&) = delete;
+        Instance_buffer(Instance_buffer&&) noexcept;
+
+        ~Instance_buffer();
+
+        Instance_buffer& operator=(const Instance_buffer&) = delete;
+
+    public:
+        // Replaces the contents, reallocating (orphaning) the storage so the
+        // GPU can keep reading the previous contents meanwhile.
+        void upload(const Instance_builder&);
+        void upload(const Instance* instances, std::size_t count);
+
+        std::size_t size() const;
+
+    private:
+        friend class Mesh;
+
+        // Vertex buffer binding point the instance attributes read from.
+        // Locations 3 to 7 are not used per vertex, so neither are their
+        // implicit bindings.
+        static constexpr GLuint binding = first_attribute;
+
+        // Formats, enables and binds the instance attributes of the bound
+        // vertex array; once per vertex array.
+        static void setup_attributes();
+
+        // Points the binding of the bound vertex array here.
+        void bind() const;
+
+        GLuint buffer_{0};
+        std::size_t size_{0};
+    };
+
+} // namespace opengl
+} // namespace kgfx
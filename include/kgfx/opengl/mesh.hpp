@@ -1,18 +1,34 @@
 #pragma once
 #include <GL/glew.h>
 #include "../mesh.hpp"
+#include "../vertex_layout.hpp"
 
 namespace kgfx {
 namespace opengl {
     
     class Render;
+    class Instance_buffer;
+    class Mesh_uploader;
 
     class Mesh 
     {
+        friend class Mesh_uploader;
+
     public:
         Mesh() = default;
         Mesh(const Mesh&) = delete;
-        Mesh(const Triangle_mesh<>&);
+
+        // Any vertex type with a Vertex_layout.
+        template <typename Vertex_type>
+        Mesh(const Triangle_mesh<Vertex_type>& source)
+        {
+            upload(source.vertices.data(),
+                   source.vertices.size(),
+                   vertex_format<Vertex_type>(),
+                   source.triangles.data(),
+                   source.triangles.size());
+        }
+
         Mesh(Mesh&& other) noexcept;
 
         ~Mesh();
@@ -23,19 +39,69 @@ namespace opengl {
 
         void swap(Mesh&);
 
+        // The vertex array name, e.g. for sort keys.
+        GLuint vertex_array() const;
+
     public :
-        void load_mesh(const Triangle_mesh<>&);
+        template <typename Vertex_type>
+        void load_mesh(const Triangle_mesh<Vertex_type>& source)
+        {
+            destroy();
+
+            Mesh mesh(source);
+            if (mesh) {
+                mesh.swap(*this);
+            }
+        }
+
+        // Lets 'generator' (see mesh_generator.hpp) write straight into mapped
+        // buffer storage, skipping the intermediate Triangle_mesh copy.
+        template <typename Generator>
+        void load_generated(const Generator& generator)
+        {
+            Mesh mesh;
+
+            Vertex* vertices = nullptr;
+            Triangle* triangles = nullptr;
+            if (mesh.map_buffers(generator.size(), vertices, triangles)) {
+                generator.generate(vertices, triangles, 0u);
+                mesh.unmap_buffers();
+            }
+
+            mesh.swap(*this);
+        }
 
     public: 
         void render();
 
+        // One draw for all instances in 'instances' (or 'count' of them from
+        // 'first'). See Instance_buffer for the attribute locations; the
+        // first instanced draw sets them up in the vertex array, later ones
+        // only bind the buffer.
+        void render_instanced(const Instance_buffer& instances);
+        void render_instanced(const Instance_buffer& instances,
+                              std::size_t first,
+                              std::size_t count);
+
     private :
         //void set_draw_mode(GLenum draw_mode);
 
         //typedef graphics::mesh::Vertex Vertex;
-        void setup_vertex_buffer_object(const Vertex* vertices, size_t vertex_count);
+        void upload(const void* vertices,
+                    std::size_t vertex_count,
+                    const Vertex_format& format,
+                    const Triangle* triangles,
+                    std::size_t triangle_count);
+
+        void setup_vertex_buffer_object(const void* vertices, size_t vertex_count, size_t vertex_size);
         void setup_element_buffer_object(const GLuint* indices, size_t index_count);
-        void setup_vertex_array_object(); 
+        void setup_vertex_array_object(const Vertex_format& format = vertex_format<Vertex>());
+
+        bool map_buffers(const Mesh_size& size, Vertex*& vertices, Triangle*& triangles);
+        void unmap_buffers();
+
+        // Uninitialized storage, for the contents to be copied in on the GPU.
+        void allocate_buffers(std::size_t num_vertices, std::size_t num_indices);
 
     private: 
         void destroy();
@@ -47,6 +113,8 @@ namespace opengl {
         GLuint render_count_{0};
 
         GLenum draw_mode_{GL_TRIANGLES};
+
+        bool instance_attributes_{false};
     };
 
 } // namespace opengl
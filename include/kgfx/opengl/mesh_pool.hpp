@@ -0,0 +1,96 @@
+#pragma once
+#include <GL/glew.h>
+#include "../mesh.hpp"
+#include "../range_allocator.hpp"
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // Layout fixed by glMultiDrawElementsIndirect.
+    struct Draw_elements_indirect_command {
+        GLuint count{0};
+        GLuint instance_count{1};
+        GLuint first_index{0};
+        GLint base_vertex{0};
+        GLuint base_instance{0};
+    };
+
+    // Many meshes in one shared vertex buffer and one shared index buffer,
+    // drawn through a single vertex array object.
+    //
+    // Meshes are sub-allocated with a Range_allocator and drawn by first
+    // index and base vertex, so switching meshes costs no buffer or vertex
+    // array binds. Meshes are referred to by id, and the pool may move their
+    // data around: defragment() packs all meshes to the front of the buffers,
+    // which allocate() also does by itself when only fragmentation is in the
+    // way. A pool holds one vertex format, kgfx::Vertex.
+    class Mesh_pool
+    {
+    public:
+        using Mesh_id = unsigned;
+
+        struct Stats {
+            Range_allocator::Stats vertices;
+            Range_allocator::Stats indices;
+            std::size_t num_meshes{0};
+            std::size_t vertex_bytes_used{0};
+            std::size_t index_bytes_used{0};
+        };
+
+        Mesh_pool(std::size_t max_vertices, std::size_t max_indices);
+        Mesh_pool(const Mesh_pool&) = delete;
+
+        ~Mesh_pool();
+
+        Mesh_pool& operator=(const Mesh_pool&) = delete;
+
+    public:
+        // Throws when the pool cannot hold the mesh even after defragmenting.
+        Mesh_id allocate(const Triangle_mesh<>&);
+
+        void free(Mesh_id);
+
+        // Moves all meshes to the front of the buffers, leaving one free range.
+        void defragment();
+
+        Stats stats() const;
+
+    public:
+        // Binds the shared vertex array; render(id) then only issues the draw.
+        void bind() const;
+
+        void render(Mesh_id) const;
+
+        // Indirect draw of one instance of the mesh.
+        Draw_elements_indirect_command draw_command(Mesh_id) const;
+
+        // Binds once and draws all of 'meshes'.
+        void render(const std::vector<Mesh_id>& meshes) const;
+
+    private:
+        struct Entry {
+            std::size_t first_vertex{0};
+            std::size_t num_vertices{0};
+            std::size_t first_index{0};
+            std::size_t num_indices{0};
+            bool live{false};
+        };
+
+        void create_buffers(GLuint& vertex_buffer, GLuint& index_buffer) const;
+        void setup_vertex_array_object();
+        void destroy();
+
+        GLuint vertex_buffer_object_{0};
+        GLuint element_buffer_object_{0};
+        GLuint vertex_array_object_{0};
+
+        Range_allocator vertex_allocator_;
+        Range_allocator index_allocator_;
+
+        std::vector<Entry> entries_;
+        std::vector<Mesh_id> free_ids_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
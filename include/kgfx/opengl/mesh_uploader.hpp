@@ -0,0 +1,121 @@
+#pragma once
+#include <GL/glew.h>
+#include "mesh.hpp"
+#include "stream_buffer.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // Builds meshes without stalling the render thread.
+    //
+    // Meshes are prepared (generated, loaded, ...) on worker threads. update(),
+    // called once per frame on the render thread, copies prepared data into
+    // a persistently mapped staging buffer and on into the mesh's own buffers
+    // with glCopyBufferSubData, at most 'frame_budget' bytes per frame; larger
+    // meshes take several frames. A mesh is ready once a fence placed after
+    // its last copy has passed, and can then be taken and drawn.
+    class Mesh_uploader
+    {
+    public:
+        using Ticket = unsigned;
+        using Prepare = std::function<Triangle_mesh<>()>;
+
+        struct Stats {
+            std::size_t num_preparing{0};
+            std::size_t num_uploading{0};
+            std::size_t num_ready{0};
+            std::size_t bytes_uploaded{0};
+        };
+
+        Mesh_uploader(GLsizeiptr frame_budget, unsigned num_threads = 1);
+        Mesh_uploader(const Mesh_uploader&) = delete;
+
+        ~Mesh_uploader();
+
+        Mesh_uploader& operator=(const Mesh_uploader&) = delete;
+
+    public:
+        // Calls 'prepare' on a worker thread.
+        Ticket submit(Prepare prepare);
+
+        // Runs 'generator' (see mesh_generator.hpp) on a worker thread.
+        template <typename Generator>
+        Ticket submit_generator(Generator generator)
+        {
+            return submit([generator = std::move(generator)]() {
+                Triangle_mesh<> mesh;
+                mesh.generate(generator);
+                return mesh;
+            });
+        }
+
+        // Render thread, once per frame.
+        void update();
+
+        bool is_ready(Ticket) const;
+
+        // The finished mesh; the ticket is invalid afterwards. Rethrows what
+        // the preparation threw.
+        Mesh take(Ticket);
+
+        // Of the last update(), 'bytes_uploaded' in that frame.
+        const Stats& stats() const;
+
+    private:
+        enum class State { preparing,
+                           uploading,
+                           ready,
+                           unused };
+
+        struct Entry {
+            State state{State::unused};
+            std::unique_ptr<Triangle_mesh<>> source;
+            Mesh mesh;
+            GLsizeiptr bytes_copied{0};
+            GLsync fence{nullptr};
+            std::exception_ptr error;
+        };
+
+        struct Prepared {
+            Ticket ticket{0};
+            std::unique_ptr<Triangle_mesh<>> source;
+            std::exception_ptr error;
+        };
+
+        void work();
+        void collect_prepared();
+        void poll_fences();
+
+        // Copies as much of the entry as is left of this frame's staging
+        // region. True when all of it has been copied.
+        bool copy(Entry& entry);
+
+        Stream_buffer staging_;
+
+        std::vector<Entry> entries_;
+        std::vector<Ticket> free_tickets_;
+        std::deque<Ticket> upload_queue_;
+        Stats stats_;
+
+        // Shared with the workers.
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::deque<std::pair<Ticket, Prepare>> jobs_;
+        std::vector<Prepared> prepared_;
+        bool stop_{false};
+
+        std::vector<std::thread> workers_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
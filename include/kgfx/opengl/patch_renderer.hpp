@@ -0,0 +1,71 @@
+#pragma once
+#include <GL/glew.h>
+#include "shader.hpp"
+#include "../bezier.hpp"
+#include "../my_glm.hpp"
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // Renders bicubic Bezier patches evaluated on the GPU.
+    //
+    // Only the 16 control points per patch are uploaded (to a shader storage
+    // buffer). Patches are grouped by grid resolution, every group draws one
+    // shared UV grid instanced once per patch, and the vertex shader evaluates
+    // position and normal from the control points. Needs OpenGL 4.3.
+    class Patch_renderer
+    {
+    public:
+        using Patch = Bezier_patch<glm::vec3, float>;
+
+        // Compiles the built-in shaders. Requires a current context.
+        Patch_renderer();
+        Patch_renderer(const Patch_renderer&) = delete;
+        ~Patch_renderer();
+
+        Patch_renderer& operator=(const Patch_renderer&) = delete;
+
+    public:
+        // Replaces all patches. 'resolutions[i]' is the number of samples per
+        // side of patch i, at least 2.
+        void load_patches(const std::vector<Patch>& patches,
+                          const std::vector<unsigned>& resolutions);
+
+        void set_view_projection(const glm::mat4&);
+
+        void render();
+
+        // Evaluates every patch on the GPU without rasterizing and reads back
+        // the samples: patch by patch, row major like Bezier_patch::sample_grid.
+        void capture(std::vector<glm::vec3>& positions,
+                     std::vector<glm::vec3>& normals);
+
+    private:
+        // Patches sharing one grid resolution.
+        struct Group {
+            unsigned resolution{0};
+            GLuint vertex_buffer_object{0};
+            GLuint element_buffer_object{0};
+            GLuint vertex_array_object{0};
+            GLsizei index_count{0};
+            GLuint first_instance{0};
+            GLsizei instance_count{0};
+        };
+
+        void setup_group(Group&);
+        void destroy_patches();
+
+    private:
+        Shader_program program_;
+        Shader_uniform<glm::mat4> view_projection_;
+
+        GLuint control_point_buffer_{0};
+        GLuint instance_buffer_object_{0};
+
+        std::vector<Group> groups_;
+        std::vector<unsigned> instance_patches_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
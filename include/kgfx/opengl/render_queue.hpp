@@ -0,0 +1,66 @@
+#pragma once
+#include <GL/glew.h>
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "../my_glm.hpp"
+#include "../sort_key.hpp"
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // Draws submitted during a frame, executed in sort key order (see
+    // sort_key.hpp): by layer, opaque before translucent, opaque grouped by
+    // program and mesh and drawn front to back, translucent drawn back to
+    // front. Consecutive draws with the same program or mesh skip rebinding
+    // it.
+    class Render_queue
+    {
+    public:
+        struct Stats {
+            std::size_t num_draws{0};
+            std::size_t num_program_changes{0};
+            std::size_t num_mesh_changes{0};
+        };
+
+        Render_queue() = default;
+        Render_queue(const Render_queue&) = delete;
+
+        Render_queue& operator=(const Render_queue&) = delete;
+
+    public:
+        // 'depth' is the view depth scaled to [0, 1], 0 nearest. The
+        // transform is set to 'transform_uniform' (of 'shader') before the
+        // draw.
+        void submit(unsigned layer,
+                    bool translucent,
+                    Shader_program& shader,
+                    Mesh& mesh,
+                    Shader_uniform<glm::mat4> transform_uniform,
+                    const glm::mat4& transform,
+                    float depth);
+
+        // Sorts and draws everything submitted since the last call, then
+        // clears.
+        void render();
+
+        // Of the last render().
+        const Stats& stats() const;
+
+    private:
+        struct Packet {
+            Shader_program* shader{nullptr};
+            Mesh* mesh{nullptr};
+            Shader_uniform<glm::mat4> transform_uniform;
+            glm::mat4 transform;
+        };
+
+        std::vector<Packet> packets_;
+        std::vector<Keyed_index> keys_;
+        std::vector<Keyed_index> scratch_;
+
+        Stats stats_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
@@ -1,10 +1,13 @@
 #pragma once
+#include "frame_profiler.hpp"
 #include "mesh.hpp"
+#include "render_queue.hpp"
 #include "shader.hpp"
 #include "../frame_time.hpp"
 #include <klib/fast_delegate.hpp>
 #include <SDL.h>
 #include <memory>
+#include <vector>
 
 namespace kgfx {
 
@@ -17,6 +20,9 @@ namespace kgfx {
     public :
         virtual void render() = 0;
         virtual void update(Frame_time&) = 0;
+
+        // Shown in profiler reports.
+        virtual const char* name() const { return "render system"; }
     }; 
 
 namespace opengl {
@@ -27,15 +33,30 @@ namespace opengl {
     class Renderer 
     {
     public :
-        Renderer() = default;
+        Renderer();
         Renderer(const Renderer&) = delete;
 
         ~Renderer();
 
     public :
+        // 'debug_context' requests a debug context, which some drivers need
+        // before they report anything to Debug_output.
         void construct_windowed(unsigned window_width,
                                 unsigned window_height,
-                                const char* window_title);
+                                const char* window_title,
+                                bool debug_context = false);
+
+        // No window or display: an EGL context (surfaceless, or on a pbuffer)
+        // rendering into an offscreen framebuffer of the given size. Works
+        // on machines without a GPU with Mesa's llvmpipe, for tests and
+        // benchmarks. Throws when EGL is unavailable.
+        void construct_headless(unsigned width,
+                                unsigned height,
+                                bool debug_context = false);
+
+        // RGBA, bottom row first, of the framebuffer drawn to; meant for the
+        // offscreen one of a headless renderer.
+        void read_pixels(std::vector<unsigned char>& rgba) const;
 
     public :
 		/*using Render_callback = klib::Fast_delegate<void>;
@@ -48,6 +69,14 @@ namespace opengl {
         void add_render_system(Render_system*);
         void remove_render_system(Render_system*);
 
+        // Render systems may submit here instead of drawing; the queue is
+        // sorted and drawn after all systems have rendered.
+        Render_queue& render_queue();
+
+        // Times of each render system's render() and update(), and of
+        // drawing the render queue.
+        const Frame_profiler& profiler() const;
+
     public :
         void run_frame();
 
@@ -56,6 +85,8 @@ namespace opengl {
         void update();
         void present();
 
+        void setup_context_state();
+
     public: 
         //Mesh allocate_mesh(const Triangle_mesh<>&);
 
@@ -72,9 +103,25 @@ namespace opengl {
         SDL_Window* window_{nullptr};
         SDL_GLContext context_{nullptr};
 
+        struct Headless_context;
+        std::unique_ptr<Headless_context> headless_;
+
+        unsigned width_{0};
+        unsigned height_{0};
+
         //klib::Delegate_list<Render_callback> render_callbacks_;
         //klib::Delegate_list<Update_callback> update_callbacks_;
-        std::vector<Render_system*> render_systems_;
+        struct Profiled_system {
+            Render_system* system;
+            Frame_profiler::Section render;
+            Frame_profiler::Section update;
+        };
+
+        std::vector<Profiled_system> render_systems_;
+
+        Render_queue render_queue_;
+        Frame_profiler profiler_;
+        Frame_profiler::Section render_queue_section_{0};
     };
 
 	/*template <typename T, void (T::*Fun)()>
@@ -1,4 +1,5 @@
 #pragma once
+#include <initializer_list>
 #include <string>
 
 namespace kgfx {
@@ -36,21 +37,18 @@ namespace opengl {
         unsigned int handle_{0};
     };
 
-    //
+    // Binds a program; nothing is restored when the scope ends. Kept for
+    // existing callers, see Shader_program::bind.
     class Shader_program;
     class Shader_scope
     {
     private :
         friend class Shader_program;
 
-        Shader_scope(Shader_program* shader);
+        explicit Shader_scope(Shader_program& shader);
 
     public :
-        Shader_scope(Shader_scope&& rhs); 
-        ~Shader_scope();
-
-    private :
-        Shader_program* shader_{nullptr};
+        Shader_scope(Shader_scope&&) = default;
     };
 
     template <typename T>
@@ -59,8 +57,6 @@ namespace opengl {
     //
     class Shader_program 
     {
-        friend class Shader_scope;
-
     public:
         Shader_program() = default;
         Shader_program(const Shader_program&) = delete;
@@ -69,6 +65,12 @@ namespace opengl {
         Shader_program(const Shader& vertex_shader,
                        const Shader& fragment_shader);
 
+        // Vertex shader outputs to capture with transform feedback, interleaved
+        // in the given order.
+        Shader_program(const Shader& vertex_shader,
+                       const Shader& fragment_shader,
+                       std::initializer_list<const char*> feedback_varyings);
+
         ~Shader_program();
 
     public:
@@ -87,12 +89,18 @@ namespace opengl {
         } 
 
     public :
+        // Binds the program (through the State_cache) for the draws that
+        // follow. It stays bound until another one is, which makes binding
+        // the same program again free.
+        void bind();
+
+        [[deprecated("Nothing is restored at scope exit; use bind().")]]
         Shader_scope bind_scope();
 
-    private:
-        void bind();
-        void unbind();
+        // The GL program name, e.g. for sort keys.
+        unsigned int handle() const;
 
+    private:
         void destroy();
 
     private:
@@ -0,0 +1,120 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+
+namespace kgfx {
+namespace opengl {
+
+    // Shadow copy of the GL state kgfx changes, so binding what is already
+    // bound costs no GL call.
+    //
+    // A GL context is current on one thread at a time, so there is one cache
+    // per thread, see current(). kgfx binds programs, vertex arrays and
+    // buffers only through the cache and leaves them bound afterwards instead
+    // of restoring zero. Code that changes the same state directly, or makes
+    // another context current, must call invalidate().
+    //
+    // GL_ELEMENT_ARRAY_BUFFER is vertex array state and is never cached; bind
+    // it only with the vertex array it belongs to bound, and upload index data
+    // through another target.
+    class State_cache
+    {
+    public:
+        struct Stats {
+            std::size_t issued{0};
+            std::size_t skipped{0};
+        };
+
+        static State_cache& current();
+
+        State_cache();
+        State_cache(const State_cache&) = delete;
+
+        State_cache& operator=(const State_cache&) = delete;
+
+    public:
+        void use_program(GLuint program);
+        void bind_vertex_array(GLuint vertex_array);
+        void bind_buffer(GLenum target, GLuint buffer);
+
+        // Indexed binds are always issued; they also change the generic
+        // binding of 'target'.
+        void bind_buffer_base(GLenum target, GLuint index, GLuint buffer);
+        void bind_buffer_range(GLenum target,
+                               GLuint index,
+                               GLuint buffer,
+                               GLintptr offset,
+                               GLsizeiptr size);
+
+        // Deleting a bound object unbinds it, and its name may be reused.
+        void program_deleted(GLuint program);
+        void vertex_array_deleted(GLuint vertex_array);
+        void buffer_deleted(GLuint buffer);
+
+    public:
+        // GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND and GL_RASTERIZER_DISCARD are
+        // cached, anything else is passed through.
+        void set_enabled(GLenum capability, bool enabled);
+        void depth_func(GLenum func);
+        void depth_mask(bool write);
+        void cull_face(GLenum mode);
+        void front_face(GLenum mode);
+
+    public:
+        // Forgets everything; the next change of each state is issued.
+        void invalidate();
+
+        // Counts since the last end_frame().
+        const Stats& stats() const;
+
+        // Counts of the last completed frame.
+        const Stats& frame_stats() const;
+        void end_frame();
+
+    private:
+        enum Buffer_target { array_buffer,
+                             copy_read_buffer,
+                             copy_write_buffer,
+                             draw_indirect_buffer,
+                             pixel_pack_buffer,
+                             pixel_unpack_buffer,
+                             shader_storage_buffer,
+                             transform_feedback_buffer,
+                             uniform_buffer,
+                             num_buffer_targets,
+                             uncached_buffer_target = num_buffer_targets };
+
+        enum Capability { depth_test,
+                          cull_face_capability,
+                          blend,
+                          rasterizer_discard,
+                          num_capabilities,
+                          uncached_capability = num_capabilities };
+
+        static Buffer_target buffer_target(GLenum target);
+        static Capability capability(GLenum capability);
+
+        // False (and counted as skipped) when 'cached' already is 'value'.
+        template <typename T>
+        bool update(T& cached, T value);
+
+        static constexpr GLuint unknown_name = ~GLuint(0);
+        static constexpr GLenum unknown_enum = ~GLenum(0);
+
+        GLuint program_;
+        GLuint vertex_array_;
+        GLuint buffers_[num_buffer_targets];
+
+        // -1 unknown, 0 disabled, 1 enabled.
+        int capabilities_[num_capabilities];
+        GLenum depth_func_;
+        int depth_mask_;
+        GLenum cull_face_;
+        GLenum front_face_;
+
+        Stats stats_;
+        Stats frame_stats_;
+    };
+
+} // namespace opengl
+} // namespace kgfx
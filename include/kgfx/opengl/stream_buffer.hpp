@@ -0,0 +1,145 @@
+#pragma once
+#include <GL/glew.h>
+#include "../mesh.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace kgfx {
+namespace opengl {
+
+    // Part of the current frame's region of a Stream_buffer. 'data' is null
+    // when the request did not fit.
+    struct Stream_allocation {
+        void* data{nullptr};
+        GLintptr offset{0};
+    };
+
+    // Buffer for data written by the CPU every frame: dynamic geometry, debug
+    // lines, per-frame uniforms.
+    //
+    // Immutable storage (glBufferStorage) stays persistently and coherently
+    // mapped, split into 'num_frames' regions used round robin. A frame's
+    // region is fenced when the frame ends and waited for before the region is
+    // written again, so the CPU writes straight into GPU visible memory while
+    // the GPU still reads earlier frames: no orphaning, no driver copies, no
+    // reallocation. Needs OpenGL 4.4 or ARB_buffer_storage.
+    class Stream_buffer
+    {
+    public:
+        // Empty, to be move assigned; no frames may begin before.
+        Stream_buffer() = default;
+        Stream_buffer(GLsizeiptr frame_size, unsigned num_frames = 3);
+        Stream_buffer(const Stream_buffer&) = delete;
+        Stream_buffer(Stream_buffer&&) noexcept;
+
+        ~Stream_buffer();
+
+        Stream_buffer& operator=(const Stream_buffer&) = delete;
+        Stream_buffer& operator=(Stream_buffer&&) noexcept;
+
+        explicit operator bool() const;
+
+        void swap(Stream_buffer&);
+
+    public:
+        // Waits until the GPU is done with the next region and starts
+        // allocating from it.
+        void begin_frame();
+
+        // 'size' bytes in the current region, at an offset (from the start of
+        // the buffer) that is a multiple of 'alignment'.
+        Stream_allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+
+        // Like allocate, aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...).
+        Stream_allocation allocate_uniform(GLsizeiptr size);
+
+        // Fences the commands reading the current region.
+        void end_frame();
+
+    public:
+        void bind_range(GLenum target,
+                        GLuint index,
+                        const Stream_allocation&,
+                        GLsizeiptr size) const;
+
+        GLuint handle() const;
+
+        GLsizeiptr frame_size() const;
+
+        // Start of the current region and bytes allocated from it.
+        GLintptr frame_offset() const;
+        GLsizeiptr frame_used() const;
+
+    private:
+        void destroy();
+
+        GLuint buffer_{0};
+        char* mapped_{nullptr};
+
+        GLsizeiptr frame_size_{0};
+        GLsizeiptr frame_used_{0};
+        GLsizeiptr uniform_alignment_{256};
+        unsigned frame_{0};
+
+        std::vector<GLsync> fences_;
+    };
+
+    // Triangles regenerated every frame (debug geometry, strokes, particles),
+    // written by generators (see mesh_generator.hpp) straight into a pair of
+    // stream buffers.
+    class Dynamic_mesh
+    {
+    public:
+        Dynamic_mesh() = default;
+        Dynamic_mesh(std::size_t max_vertices,
+                     std::size_t max_triangles,
+                     unsigned num_frames = 3);
+        Dynamic_mesh(const Dynamic_mesh&) = delete;
+
+        ~Dynamic_mesh();
+
+        Dynamic_mesh& operator=(const Dynamic_mesh&) = delete;
+
+    public:
+        void begin_frame();
+
+        // Appends the generator's output to this frame. False, and nothing
+        // written, when the frame is full.
+        template <typename Generator>
+        bool add(const Generator& generator)
+        {
+            const Mesh_size size = generator.size();
+
+            Vertex* vertices = nullptr;
+            Triangle* triangles = nullptr;
+            if (!reserve(size, vertices, triangles)) {
+                return false;
+            }
+
+            generator.generate(vertices, triangles, num_vertices_);
+
+            num_vertices_ += static_cast<GLuint>(size.num_vertices);
+            num_triangles_ += static_cast<GLuint>(size.num_triangles);
+            return true;
+        }
+
+        // Draws everything added this frame.
+        void render();
+
+        void end_frame();
+
+    private:
+        bool reserve(const Mesh_size&, Vertex*&, Triangle*&);
+
+        Stream_buffer vertex_stream_;
+        Stream_buffer index_stream_;
+        GLuint vertex_array_object_{0};
+
+        GLintptr first_vertex_{0};
+        GLintptr first_index_{0};
+        GLuint num_vertices_{0};
+        GLuint num_triangles_{0};
+    };
+
+} // namespace opengl
+} // namespace kgfx
@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace kgfx {
+
+    // Calls fun(i) for every i in [begin, end), split in contiguous chunks over
+    // the hardware threads. The calling thread takes the last chunk. Blocks
+    // until all chunks are done and rethrows the first exception, if any.
+    // Runs serially when there are fewer than 2 * 'min_chunk_size' items.
+    template <typename Fun>
+    void parallel_for(unsigned begin,
+                      unsigned end,
+                      Fun fun,
+                      unsigned min_chunk_size = 1)
+    {
+        const unsigned count = end > begin ? end - begin : 0;
+        const unsigned max_chunks = count / std::max(min_chunk_size, 1u);
+        const unsigned num_chunks = std::min(std::max(std::thread::hardware_concurrency(), 1u),
+                                             max_chunks);
+
+        if (num_chunks <= 1)
+        {
+            for (unsigned i = begin; i < end; ++i)
+            {
+                fun(i);
+            }
+
+            return;
+        }
+
+        auto run_chunk = [&fun](unsigned first, unsigned last) {
+            for (unsigned i = first; i < last; ++i)
+            {
+                fun(i);
+            }
+        };
+
+        std::vector<std::future<void>> chunks;
+        chunks.reserve(num_chunks - 1);
+
+        const unsigned chunk_size = count / num_chunks;
+        unsigned first = begin;
+        for (unsigned chunk = 0; chunk + 1 < num_chunks; ++chunk)
+        {
+            chunks.push_back(std::async(std::launch::async, run_chunk, first, first + chunk_size));
+            first += chunk_size;
+        }
+
+        run_chunk(first, end);
+
+        for (auto& chunk : chunks)
+        {
+            chunk.get();
+        }
+    }
+
+} // namespace kgfx
@@ -0,0 +1,173 @@
+#pragma once
+#include "bezier.hpp"
+#include "bounding_box.hpp"
+#include <cmath>
+#include <limits>
+
+// Ray casting against bicubic Bezier patches, without tessellating them.
+//
+// The patch is subdivided recursively and sub-patches whose control point
+// boxes miss the ray are dropped. Each remaining leaf seeds a Newton
+// iteration on the original patch, which converges to the exact surface
+// point in a few steps. The nearest converged hit wins.
+
+namespace kgfx {
+
+    // Patch parameters and ray distance (in units of the ray direction) of a hit.
+    template <typename T>
+    struct Patch_hit {
+        T u{0};
+        T v{0};
+        T t{0};
+    };
+
+    namespace detail {
+
+        // The ray as the intersection of two planes, dot(normal, p) + offset = 0.
+        template <typename Point, typename T>
+        struct Ray_planes {
+            explicit Ray_planes(const Ray<Point>& ray)
+            {
+                const Point& d = ray.direction;
+                if (std::abs(d.x) > std::abs(d.y) && std::abs(d.x) > std::abs(d.z)) {
+                    normal0 = Point(d.y, -d.x, T(0));
+                } else {
+                    normal0 = Point(T(0), d.z, -d.y);
+                }
+
+                normal0 = normal0 / std::sqrt(dot(normal0, normal0));
+                normal1 = cross(normal0, d);
+                normal1 = normal1 / std::sqrt(dot(normal1, normal1));
+
+                offset0 = -dot(normal0, ray.origin);
+                offset1 = -dot(normal1, ray.origin);
+            }
+
+            Point normal0;
+            Point normal1;
+            T offset0;
+            T offset1;
+        };
+
+        // Newton iteration on the distances of S(u, v) to both ray planes.
+        template <typename Point, typename T>
+        bool newton_patch_hit(const Ray<Point>& ray,
+                              const Ray_planes<Point, T>& planes,
+                              const Bezier_patch<Point, T>& patch,
+                              T u,
+                              T v,
+                              T tolerance,
+                              Patch_hit<T>& hit)
+        {
+            const int max_iterations = 12;
+            for (int i = 0; i < max_iterations; ++i)
+            {
+                const Point p = patch.sample(u, v);
+                const T f0 = dot(planes.normal0, p) + planes.offset0;
+                const T f1 = dot(planes.normal1, p) + planes.offset1;
+
+                if (std::abs(f0) <= tolerance && std::abs(f1) <= tolerance)
+                {
+                    const T epsilon = T(1e-5);
+                    if (u < -epsilon || u > T(1) + epsilon || v < -epsilon || v > T(1) + epsilon) {
+                        return false;
+                    }
+
+                    hit.u = std::min(std::max(u, T(0)), T(1));
+                    hit.v = std::min(std::max(v, T(0)), T(1));
+                    hit.t = dot(p - ray.origin, ray.direction) / dot(ray.direction, ray.direction);
+                    return true;
+                }
+
+                const Point du = patch.derivative_u(u, v);
+                const Point dv = patch.derivative_v(u, v);
+                const T j00 = dot(planes.normal0, du);
+                const T j01 = dot(planes.normal0, dv);
+                const T j10 = dot(planes.normal1, du);
+                const T j11 = dot(planes.normal1, dv);
+
+                const T determinant = j00 * j11 - j01 * j10;
+                if (!(std::abs(determinant) > T(0))) {
+                    return false;
+                }
+
+                u -= (j11 * f0 - j01 * f1) / determinant;
+                v -= (j00 * f1 - j10 * f0) / determinant;
+
+                // Far outside the patch, the iteration is chasing another root.
+                if (u < T(-0.5) || u > T(1.5) || v < T(-0.5) || v > T(1.5)) {
+                    return false;
+                }
+            }
+
+            return false;
+        }
+
+        template <typename Point, typename T>
+        void intersect_subpatch(const Ray<Point>& ray,
+                                const Ray_planes<Point, T>& planes,
+                                const Bezier_patch<Point, T>& patch,
+                                const Bezier_patch<Point, T>& subpatch,
+                                T u0,
+                                T v0,
+                                T size,
+                                unsigned depth,
+                                T tolerance,
+                                T t_min,
+                                Patch_hit<T>& nearest,
+                                bool& found)
+        {
+            T t_near = t_min;
+            T t_far = found ? nearest.t : std::numeric_limits<T>::max();
+            if (!intersect(ray, subpatch.bounding_box(), t_near, t_far)) {
+                return;
+            }
+
+            if (depth == 0)
+            {
+                Patch_hit<T> hit;
+                if (newton_patch_hit(ray, planes, patch, u0 + size * T(0.5), v0 + size * T(0.5), tolerance, hit)
+                    && hit.t >= t_min
+                    && (!found || hit.t < nearest.t))
+                {
+                    nearest = hit;
+                    found = true;
+                }
+                return;
+            }
+
+            const T half = size * T(0.5);
+            int quadrant = 0;
+            subpatch.for_each_quadrant([&](const Bezier_patch<Point, T>& q) {
+                intersect_subpatch(ray, planes, patch, q,
+                                   u0 + half * static_cast<T>(quadrant % 2),
+                                   v0 + half * static_cast<T>(quadrant / 2),
+                                   half, depth - 1, tolerance, t_min, nearest, found);
+                ++quadrant;
+            });
+        }
+
+    } // namespace detail
+
+    // Nearest intersection of the ray with the patch at t >= t_min. 'depth'
+    // is the number of subdivision levels before switching to Newton; deeper
+    // separates nearby roots (folds, silhouettes) at the cost of more boxes.
+    template <typename Point, typename T>
+    bool intersect(const Ray<Point>& ray,
+                   const Bezier_patch<Point, T>& patch,
+                   Patch_hit<T>& hit,
+                   unsigned depth = 4,
+                   T t_min = T(0))
+    {
+        const auto box = patch.bounding_box();
+        const Point size = box.size();
+        const T tolerance = T(1e-6) * std::max(T(1), std::sqrt(dot(size, size)));
+
+        const detail::Ray_planes<Point, T> planes(ray);
+
+        bool found = false;
+        detail::intersect_subpatch(ray, planes, patch, patch, T(0), T(0), T(1), depth, tolerance, t_min, hit, found);
+        return found;
+    }
+
+} // namespace kgfx
@@ -0,0 +1,155 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+namespace kgfx {
+
+    // Hands out ranges [offset, offset + size) of a fixed capacity, in any
+    // unit (bytes, vertices, indices). Free ranges are kept by offset, to merge
+    // neighbours when a range is returned, and by size, for best fit
+    // allocation in O(log n).
+    class Range_allocator {
+    public:
+        struct Stats {
+            std::size_t capacity{0};
+            std::size_t used{0};
+            std::size_t free{0};
+            std::size_t largest_free{0};
+            std::size_t num_free_ranges{0};
+            std::size_t num_allocations{0};
+
+            // 0 when all free space is one range, towards 1 as it splinters.
+            float fragmentation() const
+            {
+                return free > 0 ? 1.0f - static_cast<float>(largest_free) / static_cast<float>(free) : 0.0f;
+            }
+        };
+
+        Range_allocator() = default;
+
+        explicit Range_allocator(std::size_t capacity)
+        {
+            reset(capacity);
+        }
+
+    public:
+        // False, and 'offset' untouched, when no free range is large enough.
+        bool allocate(std::size_t size, std::size_t& offset)
+        {
+            assert(size > 0);
+
+            const auto best = by_size_.lower_bound(size);
+            if (best == by_size_.end()) {
+                return false;
+            }
+
+            offset = best->second;
+            const std::size_t free_size = best->first;
+            by_size_.erase(best);
+            by_offset_.erase(offset);
+
+            if (free_size > size) {
+                insert_free(offset + size, free_size - size);
+            }
+
+            used_ += size;
+            ++num_allocations_;
+            return true;
+        }
+
+        void free(std::size_t offset, std::size_t size)
+        {
+            assert(size > 0);
+            assert(used_ >= size);
+
+            used_ -= size;
+            --num_allocations_;
+
+            // Merge with the free range after, then with the one before.
+            const auto next = by_offset_.find(offset + size);
+            if (next != by_offset_.end())
+            {
+                size += next->second;
+                erase_free(next);
+            }
+
+            const auto after = by_offset_.lower_bound(offset);
+            if (after != by_offset_.begin())
+            {
+                const auto previous = std::prev(after);
+                if (previous->first + previous->second == offset)
+                {
+                    offset = previous->first;
+                    size += previous->second;
+                    erase_free(previous);
+                }
+            }
+
+            insert_free(offset, size);
+        }
+
+        // Everything free again.
+        void reset(std::size_t capacity)
+        {
+            by_offset_.clear();
+            by_size_.clear();
+
+            capacity_ = capacity;
+            used_ = 0;
+            num_allocations_ = 0;
+
+            if (capacity > 0) {
+                insert_free(0, capacity);
+            }
+        }
+
+        std::size_t capacity() const
+        {
+            return capacity_;
+        }
+
+        Stats stats() const
+        {
+            Stats s;
+            s.capacity = capacity_;
+            s.used = used_;
+            s.free = capacity_ - used_;
+            s.largest_free = by_size_.empty() ? 0 : by_size_.rbegin()->first;
+            s.num_free_ranges = by_offset_.size();
+            s.num_allocations = num_allocations_;
+            return s;
+        }
+
+    private:
+        void insert_free(std::size_t offset, std::size_t size)
+        {
+            by_offset_.emplace(offset, size);
+            by_size_.emplace(size, offset);
+        }
+
+        void erase_free(std::map<std::size_t, std::size_t>::iterator range)
+        {
+            auto sized = by_size_.equal_range(range->second);
+            for (auto it = sized.first; it != sized.second; ++it)
+            {
+                if (it->second == range->first)
+                {
+                    by_size_.erase(it);
+                    break;
+                }
+            }
+
+            by_offset_.erase(range);
+        }
+
+        std::map<std::size_t, std::size_t> by_offset_;
+        std::multimap<std::size_t, std::size_t> by_size_;
+
+        std::size_t capacity_{0};
+        std::size_t used_{0};
+        std::size_t num_allocations_{0};
+    };
+
+} // namespace kgfx
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace kgfx {
+
+    // Statistics over the last 'window' samples, e.g. per-frame timings.
+    class Rolling_stat
+    {
+    public:
+        explicit Rolling_stat(std::size_t window = 120)
+            : samples_(window, 0.0)
+        {
+            assert(window > 0);
+        }
+
+    public:
+        void add(double sample)
+        {
+            if (count_ == samples_.size()) {
+                sum_ -= samples_[next_];
+            }
+            else {
+                ++count_;
+            }
+
+            samples_[next_] = sample;
+            sum_ += sample;
+            last_ = sample;
+            next_ = (next_ + 1) % samples_.size();
+        }
+
+        void clear()
+        {
+            next_ = 0;
+            count_ = 0;
+            sum_ = 0.0;
+            last_ = 0.0;
+        }
+
+    public:
+        std::size_t size() const
+        {
+            return count_;
+        }
+
+        double last() const
+        {
+            return last_;
+        }
+
+        double average() const
+        {
+            return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0;
+        }
+
+        double min() const
+        {
+            return count_ > 0 ? *std::min_element(samples_.begin(), samples_.begin() + count_) : 0.0;
+        }
+
+        double max() const
+        {
+            return count_ > 0 ? *std::max_element(samples_.begin(), samples_.begin() + count_) : 0.0;
+        }
+
+    private:
+        std::vector<double> samples_;
+        std::size_t next_{0};
+        std::size_t count_{0};
+        double sum_{0.0};
+        double last_{0.0};
+    };
+
+} // namespace kgfx
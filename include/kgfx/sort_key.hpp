@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace kgfx {
+
+    // 64-bit draw sort keys; sorting by key gives the submission order.
+    //
+    //     63..60  layer        drawn in increasing order
+    //         59  translucent  opaque first within a layer
+    //
+    // then, for opaque draws (state first, then front to back):
+    //
+    //     58..47  program
+    //     46..31  material     vertex array, textures, ...
+    //     30..7   depth
+    //
+    // and for translucent draws (back to front, then state):
+    //
+    //     58..35  inverted depth
+    //     34..23  program
+    //     22..7   material
+    //
+    // Program and material are ids, truncated to their bits. Depth is in
+    // [0, 1], 0 nearest, quantized to 24 bits.
+    namespace sort_key {
+
+        constexpr unsigned layer_bits = 4;
+        constexpr unsigned program_bits = 12;
+        constexpr unsigned material_bits = 16;
+        constexpr unsigned depth_bits = 24;
+
+        inline std::uint64_t quantize_depth(float depth)
+        {
+            const float max_depth = static_cast<float>((1u << depth_bits) - 1);
+            return static_cast<std::uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * max_depth);
+        }
+
+        inline std::uint64_t opaque(unsigned layer, unsigned program, unsigned material, float depth)
+        {
+            return (std::uint64_t(layer & ((1u << layer_bits) - 1)) << 60)
+                   | (std::uint64_t(program & ((1u << program_bits) - 1)) << 47)
+                   | (std::uint64_t(material & ((1u << material_bits) - 1)) << 31)
+                   | (quantize_depth(depth) << 7);
+        }
+
+        inline std::uint64_t translucent(unsigned layer, unsigned program, unsigned material, float depth)
+        {
+            const std::uint64_t inverted_depth = ((1u << depth_bits) - 1) - quantize_depth(depth);
+
+            return (std::uint64_t(layer & ((1u << layer_bits) - 1)) << 60)
+                   | (std::uint64_t(1) << 59)
+                   | (inverted_depth << 35)
+                   | (std::uint64_t(program & ((1u << program_bits) - 1)) << 23)
+                   | (std::uint64_t(material & ((1u << material_bits) - 1)) << 7);
+        }
+
+    } // namespace sort_key
+
+    struct Keyed_index {
+        std::uint64_t key;
+        std::uint32_t index;
+    };
+
+    // Stable LSD radix sort by key, a byte per pass. Passes over bytes that
+    // are the same in every key (unused low key bits, a single layer) are
+    // skipped. 'scratch' is resized as needed and can be reused across calls.
+    inline void radix_sort(std::vector<Keyed_index>& items, std::vector<Keyed_index>& scratch)
+    {
+        if (items.size() < 2) {
+            return;
+        }
+
+        // All eight histograms in one pass over the keys.
+        std::size_t counts[8][256] = {};
+        for (const auto& item : items)
+        {
+            for (unsigned pass = 0; pass < 8; ++pass)
+            {
+                ++counts[pass][(item.key >> (pass * 8)) & 0xff];
+            }
+        }
+
+        scratch.resize(items.size());
+        std::vector<Keyed_index>* source = &items;
+        std::vector<Keyed_index>* target = &scratch;
+
+        for (unsigned pass = 0; pass < 8; ++pass)
+        {
+            std::size_t* count = counts[pass];
+            const unsigned first_byte = (items[0].key >> (pass * 8)) & 0xff;
+            if (count[first_byte] == items.size()) {
+                continue;
+            }
+
+            std::size_t offset = 0;
+            for (unsigned byte = 0; byte < 256; ++byte)
+            {
+                const std::size_t n = count[byte];
+                count[byte] = offset;
+                offset += n;
+            }
+
+            for (const auto& item : *source)
+            {
+                (*target)[count[(item.key >> (pass * 8)) & 0xff]++] = item;
+            }
+
+            std::swap(source, target);
+        }
+
+        if (source != &items) {
+            items.swap(scratch);
+        }
+    }
+
+} // namespace kgfx
@@ -0,0 +1,262 @@
+#pragma once
+#include "bezier.hpp"
+#include "mesh.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Curves as lines and ribbons.
+//
+// flatten() turns a Bezier_curve into a polyline whose points follow the
+// curvature: straight parts become single segments, tight bends get as many
+// as the tolerance needs. Stroke_generator extrudes a polyline into a ribbon
+// of constant width with miter joins, falling back to bevels at sharp turns.
+
+namespace kgfx {
+
+    namespace detail {
+
+        // Distance from 'p' to the segment [a, b].
+        template <typename Point, typename T>
+        T distance_to_segment(const Point& p, const Point& a, const Point& b)
+        {
+            const Point ab = b - a;
+            const Point ap = p - a;
+            const T length2 = dot(ab, ab);
+
+            T t(0);
+            if (length2 > T(0)) {
+                t = std::min(std::max(dot(ap, ab) / length2, T(0)), T(1));
+            }
+
+            const Point d = ap - ab * t;
+            return std::sqrt(dot(d, d));
+        }
+
+        template <typename Curve, typename Point, typename T>
+        void flatten_segment(const Curve& curve,
+                             T t0,
+                             const Point& p0,
+                             T t1,
+                             const Point& p1,
+                             T tolerance,
+                             unsigned depth,
+                             std::vector<Point>& out)
+        {
+            // The midpoint alone misses S-bends that cross the chord there.
+            const T tm = (t0 + t1) * T(0.5);
+            const Point pm = curve.sample(tm);
+            const Point q1 = curve.sample((t0 + tm) * T(0.5));
+            const Point q3 = curve.sample((tm + t1) * T(0.5));
+
+            if (depth == 0
+                || (distance_to_segment<Point, T>(pm, p0, p1) <= tolerance
+                    && distance_to_segment<Point, T>(q1, p0, p1) <= tolerance
+                    && distance_to_segment<Point, T>(q3, p0, p1) <= tolerance))
+            {
+                out.push_back(p1);
+                return;
+            }
+
+            flatten_segment(curve, t0, p0, tm, pm, tolerance, depth - 1, out);
+            flatten_segment(curve, tm, pm, t1, p1, tolerance, depth - 1, out);
+        }
+
+    } // namespace detail
+
+    // Appends a polyline within 'tolerance' of the curve to 'out'. The first
+    // point is skipped when it equals the last point already in 'out', so
+    // consecutive curves chain into one polyline.
+    template <typename Point, typename T, int degree>
+    void flatten(const Bezier_curve<Point, T, degree>& curve,
+                 T tolerance,
+                 std::vector<Point>& out,
+                 unsigned max_depth = 16)
+    {
+        assert(tolerance > T(0));
+
+        const Point start = curve.sample(T(0));
+        if (out.empty() || !(out.back() == start))
+        {
+            out.push_back(start);
+        }
+
+        detail::flatten_segment(curve, T(0), start, T(1), curve.sample(T(1)), tolerance, max_depth, out);
+    }
+
+    // Generator (see mesh_generator.hpp) extruding a polyline into a ribbon
+    // of 'width', lying across 'normal' (the plane normal, or the direction
+    // towards the viewer). Front faces point along 'normal'. Ends are butt
+    // caps; a join becomes a bevel where the miter would be longer than
+    // 'miter_limit' half widths.
+    template <typename Point, typename T>
+    class Stroke_generator {
+    public:
+        Stroke_generator(const std::vector<Point>& polyline,
+                         T width,
+                         const Point& normal,
+                         T miter_limit = T(4))
+            : normal_(normal)
+        {
+            build(polyline, width * T(0.5), miter_limit);
+        }
+
+    public:
+        Mesh_size size() const
+        {
+            Mesh_size s;
+            s.num_vertices = positions_.size();
+            s.num_triangles = triangles_.size();
+            return s;
+        }
+
+        template <typename Vertex>
+        void generate(Vertex* vertices,
+                      Triangle* triangles,
+                      unsigned base_vertex) const
+        {
+            for (const auto& position : positions_)
+            {
+                Vertex v{};
+                v.position = position;
+                v.normal = normal_;
+                *vertices++ = v;
+            }
+
+            for (const auto& triangle : triangles_)
+            {
+                *triangles++ = triangle.offset(base_vertex);
+            }
+        }
+
+    private:
+        // Left and right vertex of the ribbon at a polyline point, as seen by
+        // the segment arriving there and by the one leaving it. They differ
+        // only at bevel joins.
+        struct Join {
+            unsigned in_left{0};
+            unsigned in_right{0};
+            unsigned out_left{0};
+            unsigned out_right{0};
+        };
+
+        Point side(const Point& direction) const
+        {
+            const Point s = cross(normal_, direction);
+            return s / std::sqrt(dot(s, s));
+        }
+
+        unsigned add_vertex(const Point& position)
+        {
+            positions_.push_back(position);
+            return static_cast<unsigned>(positions_.size() - 1);
+        }
+
+        void add_triangle(unsigned a, unsigned b, unsigned c)
+        {
+            const Point n = cross(positions_[b] - positions_[a], positions_[c] - positions_[a]);
+            if (dot(n, normal_) < T(0)) {
+                std::swap(b, c);
+            }
+
+            triangles_.push_back(Triangle(a, b, c));
+        }
+
+        void build(const std::vector<Point>& polyline, T half_width, T miter_limit)
+        {
+            // Drop repeated points, they have no direction.
+            std::vector<Point> points;
+            points.reserve(polyline.size());
+            for (const auto& p : polyline)
+            {
+                if (points.empty() || dot(p - points.back(), p - points.back()) > T(0))
+                {
+                    points.push_back(p);
+                }
+            }
+
+            if (points.size() < 2) {
+                return;
+            }
+
+            std::vector<Point> sides(points.size() - 1);
+            for (std::size_t i = 0; i + 1 < points.size(); ++i)
+            {
+                sides[i] = side(points[i + 1] - points[i]);
+            }
+
+            std::vector<Join> joins(points.size());
+            for (std::size_t i = 0; i < points.size(); ++i)
+            {
+                const Point& p = points[i];
+                Join& join = joins[i];
+
+                if (i == 0 || i + 1 == points.size())
+                {
+                    const Point& s = sides[i == 0 ? 0 : i - 1];
+                    join.in_left = join.out_left = add_vertex(p + s * half_width);
+                    join.in_right = join.out_right = add_vertex(p - s * half_width);
+                    continue;
+                }
+
+                const Point& s0 = sides[i - 1];
+                const Point& s1 = sides[i];
+                const Point sum = s0 + s1;
+                const T sum_length = std::sqrt(dot(sum, sum));
+
+                // Offset along the miter is half_width / cos(half the turn angle).
+                const T cos_half = sum_length * T(0.5);
+                const bool miter = cos_half * miter_limit > T(1);
+                const Point miter_direction = sum_length > T(0) ? sum / sum_length : s0;
+                const T miter_length = half_width / std::max(cos_half, T(1) / miter_limit);
+
+                if (miter)
+                {
+                    join.in_left = join.out_left = add_vertex(p + miter_direction * miter_length);
+                    join.in_right = join.out_right = add_vertex(p - miter_direction * miter_length);
+                    continue;
+                }
+
+                // Bevel: the inner side keeps one (limited) miter vertex, the
+                // outer side gets one vertex per segment and a triangle between.
+                const Point turn = cross(points[i] - points[i - 1], points[i + 1] - points[i]);
+                const bool turns_left = dot(turn, normal_) > T(0);
+                const T inner_sign = turns_left ? T(1) : T(-1);
+
+                const unsigned inner = add_vertex(p + miter_direction * (miter_length * inner_sign));
+                const unsigned outer_in = add_vertex(p - s0 * (half_width * inner_sign));
+                const unsigned outer_out = add_vertex(p - s1 * (half_width * inner_sign));
+
+                if (turns_left)
+                {
+                    join.in_left = join.out_left = inner;
+                    join.in_right = outer_in;
+                    join.out_right = outer_out;
+                }
+                else
+                {
+                    join.in_right = join.out_right = inner;
+                    join.in_left = outer_in;
+                    join.out_left = outer_out;
+                }
+
+                add_triangle(inner, outer_in, outer_out);
+            }
+
+            for (std::size_t i = 0; i + 1 < points.size(); ++i)
+            {
+                const Join& a = joins[i];
+                const Join& b = joins[i + 1];
+                add_triangle(a.out_right, b.in_right, b.in_left);
+                add_triangle(b.in_left, a.out_left, a.out_right);
+            }
+        }
+
+        Point normal_;
+        std::vector<Point> positions_;
+        std::vector<Triangle> triangles_;
+    };
+
+} // namespace kgfx
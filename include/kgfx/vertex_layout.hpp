@@ -0,0 +1,113 @@
+#pragma once
+#include "mesh.hpp"
+#include "my_glm.hpp"
+#include <cstddef>
+#include <type_traits>
+
+namespace kgfx {
+
+    // Component types of vertex attributes.
+    enum class Attribute_type {
+        float32,
+        uint8_normalized // 0..255 read as 0..1 in the shader.
+    };
+
+    // One attribute of a vertex type: where the shader finds it and where it
+    // lives in the vertex.
+    struct Vertex_attribute {
+        unsigned location;
+        unsigned num_components;
+        Attribute_type type;
+        std::size_t offset;
+    };
+
+    // How a member type is read as an attribute.
+    template <typename T>
+    struct Attribute_format;
+
+    template <>
+    struct Attribute_format<float> {
+        static constexpr unsigned num_components = 1;
+        static constexpr Attribute_type type = Attribute_type::float32;
+    };
+
+    template <>
+    struct Attribute_format<glm::vec2> {
+        static constexpr unsigned num_components = 2;
+        static constexpr Attribute_type type = Attribute_type::float32;
+    };
+
+    template <>
+    struct Attribute_format<glm::vec3> {
+        static constexpr unsigned num_components = 3;
+        static constexpr Attribute_type type = Attribute_type::float32;
+    };
+
+    template <>
+    struct Attribute_format<glm::vec4> {
+        static constexpr unsigned num_components = 4;
+        static constexpr Attribute_type type = Attribute_type::float32;
+    };
+
+    template <>
+    struct Attribute_format<glm::u8vec4> {
+        static constexpr unsigned num_components = 4;
+        static constexpr Attribute_type type = Attribute_type::uint8_normalized;
+    };
+
+    // Attribute 'member' of 'Type' at shader 'location'.
+    #define KGFX_VERTEX_ATTRIBUTE(Type, member, location)                                     \
+        ::kgfx::Vertex_attribute {                                                            \
+            (location),                                                                       \
+            ::kgfx::Attribute_format<decltype(Type::member)>::num_components,                 \
+            ::kgfx::Attribute_format<decltype(Type::member)>::type,                           \
+            offsetof(Type, member)                                                            \
+        }
+
+    // The attributes of a vertex type, specialized per type:
+    //
+    //     struct Slim_vertex {
+    //         glm::vec3 position;
+    //         glm::u8vec4 color;
+    //     };
+    //
+    //     namespace kgfx {
+    //         template <>
+    //         struct Vertex_layout<Slim_vertex> {
+    //             static constexpr Vertex_attribute attributes[] = {
+    //                 KGFX_VERTEX_ATTRIBUTE(Slim_vertex, position, 0),
+    //                 KGFX_VERTEX_ATTRIBUTE(Slim_vertex, color, 2),
+    //             };
+    //         };
+    //     }
+    //
+    // Locations 3 to 7 are taken by Instance_buffer.
+    template <typename Vertex>
+    struct Vertex_layout;
+
+    template <>
+    struct Vertex_layout<Vertex> {
+        static constexpr Vertex_attribute attributes[] = {
+            KGFX_VERTEX_ATTRIBUTE(Vertex, position, 0),
+            KGFX_VERTEX_ATTRIBUTE(Vertex, normal, 1),
+            KGFX_VERTEX_ATTRIBUTE(Vertex, color, 2),
+        };
+    };
+
+    // A layout with its vertex size, as passed to non-template code.
+    struct Vertex_format {
+        const Vertex_attribute* attributes;
+        std::size_t num_attributes;
+        std::size_t stride;
+    };
+
+    template <typename Vertex>
+    constexpr Vertex_format vertex_format()
+    {
+        static_assert(std::is_standard_layout<Vertex>::value, "Attribute offsets need a standard layout vertex.");
+
+        constexpr auto& attributes = Vertex_layout<Vertex>::attributes;
+        return {attributes, sizeof(attributes) / sizeof(attributes[0]), sizeof(Vertex)};
+    }
+
+} // namespace kgfx
@@ -0,0 +1,721 @@
+#include <catch.hpp>
+#include <kgfx/adaptive_tessellation.hpp>
+#include <kgfx/bezier.hpp>
+#include <kgfx/bezier_batch.hpp>
+#include <kgfx/bezier_patch.hpp>
+#include <kgfx/mesh.hpp>
+#include <kgfx/patch_intersection.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    using kgfx::Bezier_patch;
+    using kgfx::Bezier_curve;
+
+    Bezier_patch<glm::vec3, float> make_test_patch()
+    {
+        std::array<glm::vec3, 16> points;
+        for (int j = 0; j < 4; ++j)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                const float height = static_cast<float>((i * 7 + j * 3) % 5) - 2.0f;
+                points[i + j * 4] = glm::vec3(static_cast<float>(i) * 10.0f, height, static_cast<float>(j) * 10.0f);
+            }
+        }
+
+        return Bezier_patch<glm::vec3, float>(points);
+    }
+
+    float grid_parameter(unsigned i, unsigned num_samples)
+    {
+        return static_cast<float>(i) / static_cast<float>(num_samples - 1);
+    }
+
+} // namespace
+
+TEST_CASE("Forward differenced curve matches Bernstein evaluation", "[bezier]")
+{
+    const std::array<glm::vec3, 4> points = {{{0.0f, 0.0f, 0.0f},
+                                              {1.0f, 3.0f, 0.0f},
+                                              {4.0f, -2.0f, 1.0f},
+                                              {5.0f, 1.0f, 0.0f}}};
+    const std::array<float, 4> weights = {{1.0f, 0.5f, 2.0f, 1.0f}};
+    const Bezier_curve<glm::vec3, float, 4> curve(points, weights);
+
+    const unsigned num_samples = 200;
+    unsigned count = 0;
+    curve.sample_uniform(num_samples, [&](unsigned i, const glm::vec3& p) {
+        const glm::vec3 expected = curve.sample(grid_parameter(i, num_samples));
+        REQUIRE(glm::length(p - expected) < 1e-4f);
+        ++count;
+    });
+
+    REQUIRE(count == num_samples);
+}
+
+TEST_CASE("Patch grid sampling matches sample_patch", "[bezier]")
+{
+    const auto patch = make_test_patch();
+    const unsigned num_u = 97;
+    const unsigned num_v = 61;
+
+    std::vector<glm::vec3> tables(num_u * num_v);
+    std::vector<glm::vec3> forward(num_u * num_v);
+    patch.sample_grid(num_u, num_v, tables.data());
+    patch.sample_grid_forward(num_u, num_v, forward.data());
+
+    for (unsigned y = 0; y < num_v; ++y)
+    {
+        for (unsigned x = 0; x < num_u; ++x)
+        {
+            const glm::vec3 expected = kgfx::sample_patch(&patch.get_points()[0],
+                                                          grid_parameter(x, num_u),
+                                                          grid_parameter(y, num_v));
+
+            REQUIRE(glm::length(tables[x + y * num_u] - expected) < 1e-4f);
+            REQUIRE(glm::length(forward[x + y * num_u] - expected) < 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("Patch grid benchmarks", "[.][benchmark]")
+{
+    const auto patch = make_test_patch();
+    const unsigned num_u = 512;
+    const unsigned num_v = 512;
+    std::vector<glm::vec3> out(num_u * num_v);
+
+    BENCHMARK("sample_patch per point")
+    {
+        for (unsigned y = 0; y < num_v; ++y)
+        {
+            for (unsigned x = 0; x < num_u; ++x)
+            {
+                out[x + y * num_u] = kgfx::sample_patch(&patch.get_points()[0],
+                                                        grid_parameter(x, num_u),
+                                                        grid_parameter(y, num_v));
+            }
+        }
+        return out.back();
+    };
+
+    // Threaded over rows for grids this dense.
+    BENCHMARK("sample_grid")
+    {
+        patch.sample_grid(num_u, num_v, out.data());
+        return out.back();
+    };
+
+    BENCHMARK("sample_grid_forward")
+    {
+        patch.sample_grid_forward(num_u, num_v, out.data());
+        return out.back();
+    };
+}
+
+TEST_CASE("make_patch with forward differences", "[bezier][mesh]")
+{
+    const auto patch = make_test_patch();
+
+    kgfx::Triangle_mesh<> tables;
+    kgfx::Triangle_mesh<> forward;
+    tables.make_patch(patch, 33, 17);
+    forward.make_patch(patch, 33, 17, kgfx::Patch_sampling::forward_differences);
+
+    REQUIRE(forward.vertices.size() == 33 * 17);
+    REQUIRE(forward.triangles.size() == 32 * 16 * 2);
+
+    for (std::size_t i = 0; i < tables.vertices.size(); ++i)
+    {
+        REQUIRE(glm::length(tables.vertices[i].position - forward.vertices[i].position) < 1e-4f);
+    }
+}
+
+TEST_CASE("Adaptive tessellation shares edge vertices between patches", "[bezier][mesh]")
+{
+    // Two patches meeting at the u = 1 / u = 0 edge, with different curvature.
+    std::array<glm::vec3, 16> left;
+    std::array<glm::vec3, 16> right;
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            const float fi = static_cast<float>(i);
+            const float fj = static_cast<float>(j);
+            left[i + j * 4] = glm::vec3(fi * 0.37f, fj * 0.29f, std::sin(fi * 1.3f + fj));
+        }
+
+        right[j * 4] = left[3 + j * 4];
+        for (int i = 1; i < 4; ++i)
+        {
+            const float fi = static_cast<float>(i);
+            const float fj = static_cast<float>(j);
+            right[i + j * 4] = glm::vec3(left[3].x + fi * 0.41f, fj * 0.29f, std::cos(fi * 0.7f + fj * 2.0f));
+        }
+    }
+
+    const Bezier_patch<glm::vec3, float> left_patch(left);
+    const Bezier_patch<glm::vec3, float> right_patch(right);
+    const kgfx::Adaptive_patch_generator<glm::vec3, float> left_generator(left_patch, 0.0005f);
+    const kgfx::Adaptive_patch_generator<glm::vec3, float> right_generator(right_patch, 0.0005f);
+
+    REQUIRE(left_generator.levels().edges[1] == right_generator.levels().edges[3]);
+
+    kgfx::Triangle_mesh<> left_mesh;
+    kgfx::Triangle_mesh<> right_mesh;
+    left_mesh.generate(left_generator);
+    right_mesh.generate(right_generator);
+
+    REQUIRE(left_mesh.vertices.size() == left_generator.size().num_vertices);
+    REQUIRE(left_mesh.triangles.size() == left_generator.size().num_triangles);
+
+    // Every vertex on the shared edge exists, bit for bit, in the other mesh.
+    unsigned num_shared = 0;
+    for (const auto& v : left_mesh.vertices)
+    {
+        if (std::abs(v.position.x - left[3].x) < 1e-5f)
+        {
+            const bool found = std::any_of(right_mesh.vertices.begin(),
+                                           right_mesh.vertices.end(),
+                                           [&v](const kgfx::Vertex& w) { return w.position == v.position; });
+            REQUIRE(found);
+            ++num_shared;
+        }
+    }
+
+    REQUIRE(num_shared == left_generator.levels().edges[1] + 1);
+}
+
+TEST_CASE("Adaptive tessellation agrees on shared edge levels at level boundaries", "[bezier][mesh]")
+{
+    // The shared edge is walked one way by each patch. Tolerances right at
+    // a level boundary expose any difference in how the two sides round.
+    unsigned seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24) * 2.0f - 1.0f;
+    };
+
+    for (int trial = 0; trial < 2000; ++trial)
+    {
+        std::array<glm::vec3, 16> left;
+        std::array<glm::vec3, 16> right;
+        for (auto& point : left)
+        {
+            point = glm::vec3(random(), random(), random());
+        }
+
+        // Left's u = 1 edge is right's u = 0 edge.
+        for (int j = 0; j < 4; ++j)
+        {
+            right[j * 4] = left[3 + j * 4];
+            for (int i = 1; i < 4; ++i)
+            {
+                right[i + j * 4] = glm::vec3(random(), random(), random());
+            }
+        }
+
+        const glm::vec3& p0 = left[3];
+        const glm::vec3& p1 = left[7];
+        const glm::vec3& p2 = left[11];
+        const glm::vec3& p3 = left[15];
+        const float m = std::max(glm::length(p0 - p1 * 2.0f + p2), glm::length(p1 - p2 * 2.0f + p3));
+        const unsigned level = 1 + static_cast<unsigned>(trial % 16);
+        const float tolerance = 0.75f * m / static_cast<float>(level * level);
+
+        const auto left_levels = kgfx::patch_levels(Bezier_patch<glm::vec3, float>(left), tolerance);
+        const auto right_levels = kgfx::patch_levels(Bezier_patch<glm::vec3, float>(right), tolerance);
+        REQUIRE(left_levels.edges[1] == right_levels.edges[3]);
+    }
+}
+
+TEST_CASE("Adaptive tessellation of a flat patch", "[bezier][mesh]")
+{
+    std::array<glm::vec3, 16> points;
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            points[i + j * 4] = glm::vec3(static_cast<float>(i), 0.0f, static_cast<float>(j));
+        }
+    }
+
+    const Bezier_patch<glm::vec3, float> patch(points);
+    const kgfx::Adaptive_patch_generator<glm::vec3, float> generator(patch, 0.01f);
+
+    REQUIRE(generator.size().num_triangles == 4);
+}
+
+TEST_CASE("Analytic patch normals", "[bezier][mesh]")
+{
+    const auto patch = make_test_patch();
+
+    kgfx::Triangle_mesh<> mesh;
+    mesh.make_patch(patch, 9, 9, kgfx::Patch_sampling::basis_tables, kgfx::Patch_normals::analytic);
+
+    // Agrees with the face normals of a dense tessellation.
+    const float h = 1e-3f;
+    for (unsigned y = 1; y < 8; ++y)
+    {
+        for (unsigned x = 1; x < 8; ++x)
+        {
+            const float u = grid_parameter(x, 9);
+            const float v = grid_parameter(y, 9);
+            const glm::vec3 face = kgfx::calculate_normal(patch.sample(u, v),
+                                                          patch.sample(u + h, v),
+                                                          patch.sample(u + h, v + h));
+
+            const glm::vec3& normal = mesh.vertices[x + y * 9].normal;
+            REQUIRE(std::abs(glm::length(normal) - 1.0f) < 1e-4f);
+            REQUIRE(glm::dot(normal, face) > 0.999f);
+        }
+    }
+
+    // Collapse the v = 0 edge into a single point, like the pole of a sphere.
+    auto points = patch.get_points();
+    for (int i = 1; i < 4; ++i)
+    {
+        points[i] = points[0];
+    }
+
+    const Bezier_patch<glm::vec3, float> collapsed(points);
+    const glm::vec3 pole = collapsed.normal(0.5f, 0.0f);
+    const glm::vec3 inside = collapsed.normal(0.5f, 0.01f);
+
+    REQUIRE(std::abs(glm::length(pole) - 1.0f) < 1e-4f);
+    REQUIRE(glm::dot(pole, inside) > 0.99f);
+}
+
+TEST_CASE("Patch set tessellation shares border vertices", "[bezier][mesh]")
+{
+    // 2 x 2 patches over a shared 7 x 7 control net.
+    kgfx::Bezier_patch_set<glm::vec3, float> patch_set;
+    for (int j = 0; j < 7; ++j)
+    {
+        for (int i = 0; i < 7; ++i)
+        {
+            const float height = static_cast<float>((i * 5 + j * 3) % 4);
+            patch_set.add_control_point(glm::vec3(static_cast<float>(i), height, static_cast<float>(j)));
+        }
+    }
+
+    for (unsigned pj = 0; pj < 2; ++pj)
+    {
+        for (unsigned pi = 0; pi < 2; ++pi)
+        {
+            kgfx::Bezier_patch_set<glm::vec3, float>::Patch_indices indices;
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                for (unsigned i = 0; i < 4; ++i)
+                {
+                    indices[i + j * 4] = (pi * 3 + i) + (pj * 3 + j) * 7;
+                }
+            }
+            patch_set.add_patch(indices);
+        }
+    }
+
+    const unsigned n = 8;
+    kgfx::Triangle_mesh<> mesh;
+    mesh.generate(kgfx::Patch_set_generator<glm::vec3, float>(patch_set, n));
+
+    REQUIRE(mesh.vertices.size() == (2 * n + 1) * (2 * n + 1));
+    REQUIRE(mesh.triangles.size() == 4 * n * n * 2);
+
+    // Each patch's triangles land on its own surface.
+    for (std::size_t p = 0; p < 4; ++p)
+    {
+        const auto patch = patch_set.patch(p);
+        for (std::size_t t = p * n * n * 2; t < (p + 1) * n * n * 2; t += 2)
+        {
+            const unsigned x = static_cast<unsigned>((t / 2) % (n * n)) % n;
+            const unsigned y = static_cast<unsigned>((t / 2) % (n * n)) / n;
+            const glm::vec3 expected = patch.sample(grid_parameter(x, n + 1), grid_parameter(y, n + 1));
+
+            REQUIRE(glm::length(mesh.vertices[mesh.triangles[t].v0].position - expected) < 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("Rational patch reproduces a cylinder exactly", "[bezier]")
+{
+    // Quarter circle as a rational quadratic, degree elevated to cubic.
+    const float w1 = std::sqrt(0.5f);
+    const glm::vec3 arc[3] = {{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}};
+    const float arc_weights[3] = {1.0f, w1, 1.0f};
+
+    const float q1 = (arc_weights[0] + 2.0f * arc_weights[1]) / 3.0f;
+    const float q2 = (2.0f * arc_weights[1] + arc_weights[2]) / 3.0f;
+    const glm::vec3 row[4] = {arc[0],
+                              (arc[0] * arc_weights[0] + arc[1] * (2.0f * arc_weights[1])) / (3.0f * q1),
+                              (arc[1] * (2.0f * arc_weights[1]) + arc[2] * arc_weights[2]) / (3.0f * q2),
+                              arc[2]};
+    const float row_weights[4] = {arc_weights[0], q1, q2, arc_weights[2]};
+
+    std::array<glm::vec3, 16> points;
+    std::array<float, 16> weights;
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            points[i + j * 4] = row[i] + glm::vec3(0.0f, 0.0f, static_cast<float>(j));
+            weights[i + j * 4] = row_weights[i];
+        }
+    }
+
+    const kgfx::Rational_bezier_patch<glm::vec3, float> patch(points, weights);
+
+    const unsigned num_u = 33;
+    const unsigned num_v = 5;
+    std::vector<glm::vec3> grid(num_u * num_v);
+    patch.sample_grid(num_u, num_v, grid.data());
+
+    for (unsigned y = 0; y < num_v; ++y)
+    {
+        for (unsigned x = 0; x < num_u; ++x)
+        {
+            const glm::vec3& p = grid[x + y * num_u];
+            REQUIRE(std::abs(std::sqrt(p.x * p.x + p.y * p.y) - 1.0f) < 1e-5f);
+
+            const float u = grid_parameter(x, num_u);
+            const float v = grid_parameter(y, num_v);
+            REQUIRE(glm::length(p - patch.sample(u, v)) < 1e-5f);
+            REQUIRE(glm::length(p - kgfx::sample_patch_weight(&points[0], &weights[0], u, v)) < 1e-5f);
+        }
+    }
+}
+
+namespace {
+
+    template <int degree>
+    std::array<glm::vec3, degree + 1> make_test_curve()
+    {
+        std::array<glm::vec3, degree + 1> points;
+        for (int i = 0; i <= degree; ++i)
+        {
+            const float fi = static_cast<float>(i);
+            points[i] = glm::vec3(fi, std::sin(fi * 1.7f) * 3.0f, std::cos(fi * 0.9f));
+        }
+        return points;
+    }
+
+    std::vector<float> make_test_parameters(std::size_t count)
+    {
+        std::vector<float> t(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            t[i] = static_cast<float>(i) / static_cast<float>(count - 1);
+        }
+        return t;
+    }
+
+    template <int degree>
+    void check_curve_kernels()
+    {
+        const auto points = make_test_curve<degree>();
+        const auto t = make_test_parameters(257);
+
+        std::vector<glm::vec3> horner(t.size());
+        std::vector<glm::vec3> de_casteljau(t.size());
+        kgfx::evaluate_horner<degree>(points.data(), t.data(), horner.data(), t.size());
+        kgfx::evaluate_de_casteljau<degree>(points.data(), t.data(), de_casteljau.data(), t.size());
+
+        for (std::size_t i = 0; i < t.size(); ++i)
+        {
+            const glm::vec3 expected = kgfx::sample(points, t[i]);
+            REQUIRE(glm::length(horner[i] - expected) < 1e-4f);
+            REQUIRE(glm::length(de_casteljau[i] - expected) < 1e-4f);
+        }
+    }
+
+} // namespace
+
+TEST_CASE("Arbitrary degree curve kernels agree", "[bezier]")
+{
+    REQUIRE(kgfx::detail::binomial(7, 3) == 35);
+    REQUIRE(kgfx::detail::Bernstein<4, 0>::value(0.25f) == Approx(0.31640625f));
+
+    check_curve_kernels<1>();
+    check_curve_kernels<2>();
+    check_curve_kernels<3>();
+    check_curve_kernels<5>();
+    check_curve_kernels<7>();
+}
+
+TEST_CASE("Arc length table of a quarter circle", "[bezier]")
+{
+    // Rational quadratic, exact unit quarter circle.
+    const std::array<glm::vec3, 3> points = {{{1.0f, 0.0f, 0.0f},
+                                              {1.0f, 1.0f, 0.0f},
+                                              {0.0f, 1.0f, 0.0f}}};
+    const std::array<float, 3> weights = {{1.0f, std::sqrt(0.5f), 1.0f}};
+    const Bezier_curve<glm::vec3, float, 3> curve(points, weights);
+
+    const auto table = curve.arc_length_table(1e-5f);
+    REQUIRE(table.length() == Approx(std::acos(-1.0f) * 0.5f).epsilon(1e-5));
+    REQUIRE(table.size() < 64);
+
+    // Equal arc length steps give equal angles.
+    const unsigned num_steps = 90;
+    std::vector<float> distances(num_steps + 1);
+    std::vector<float> parameters(num_steps + 1);
+    for (unsigned i = 0; i <= num_steps; ++i)
+    {
+        distances[i] = table.length() * static_cast<float>(i) / static_cast<float>(num_steps);
+    }
+    table.parameters(distances.data(), parameters.data(), distances.size());
+
+    for (unsigned i = 0; i <= num_steps; ++i)
+    {
+        const glm::vec3 p = curve.sample(parameters[i]);
+        REQUIRE(std::atan2(p.y, p.x) == Approx(distances[i]).margin(1e-4));
+        REQUIRE(table.distance(parameters[i]) == Approx(distances[i]).margin(1e-4));
+
+        if (i > 0)
+        {
+            REQUIRE(parameters[i] > parameters[i - 1]);
+        }
+    }
+
+    REQUIRE(table.parameter(-1.0f) == 0.0f);
+    REQUIRE(table.parameter(table.length() + 1.0f) == Approx(1.0f));
+}
+
+TEST_CASE("Patch bounding boxes", "[bezier]")
+{
+    const auto patch = make_test_patch();
+    const auto hull = patch.bounding_box();
+    const auto tight = patch.bounding_box(3);
+
+    REQUIRE(hull.contains(tight.min));
+    REQUIRE(hull.contains(tight.max));
+
+    // A bump: the control net reaches 1, the surface 0.75^2.
+    std::array<glm::vec3, 16> bump_points;
+    for (int k = 0; k < 16; ++k)
+    {
+        const int i = k % 4;
+        const int j = k / 4;
+        const bool inner = i > 0 && i < 3 && j > 0 && j < 3;
+        bump_points[k] = glm::vec3(static_cast<float>(i), inner ? 1.0f : 0.0f, static_cast<float>(j));
+    }
+    const Bezier_patch<glm::vec3, float> bump(bump_points);
+    REQUIRE(bump.bounding_box().size().y == 1.0f);
+    REQUIRE(bump.bounding_box(3).size().y < 0.6f);
+    REQUIRE(bump.bounding_box(3).size().y >= 0.5625f);
+
+    Bezier_patch<glm::vec3, float> lower(patch.get_points());
+    Bezier_patch<glm::vec3, float> upper(patch.get_points());
+    patch.split_u(0.25f, lower, upper);
+
+    const unsigned num_samples = 33;
+    for (unsigned y = 0; y < num_samples; ++y)
+    {
+        for (unsigned x = 0; x < num_samples; ++x)
+        {
+            const float u = grid_parameter(x, num_samples);
+            const float v = grid_parameter(y, num_samples);
+            const glm::vec3 p = patch.sample(u, v);
+
+            const kgfx::Bounding_box<glm::vec3> grown(tight.min - glm::vec3(1e-4f), tight.max + glm::vec3(1e-4f));
+            REQUIRE(grown.contains(p));
+
+            REQUIRE(glm::length(lower.sample(u, v) - patch.sample(u * 0.25f, v)) < 1e-4f);
+            REQUIRE(glm::length(upper.sample(u, v) - patch.sample(0.25f + u * 0.75f, v)) < 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("Ray patch intersection", "[bezier]")
+{
+    const auto patch = make_test_patch();
+
+    const unsigned num_samples = 17;
+    for (unsigned y = 0; y < num_samples; ++y)
+    {
+        for (unsigned x = 0; x < num_samples; ++x)
+        {
+            const float u = grid_parameter(x, num_samples);
+            const float v = grid_parameter(y, num_samples);
+            const glm::vec3 target = patch.sample(u, v);
+
+            // The test patch is a height field over xz.
+            const kgfx::Ray<glm::vec3> ray{target + glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, -2.0f, 0.0f)};
+
+            kgfx::Patch_hit<float> hit;
+            REQUIRE(kgfx::intersect(ray, patch, hit));
+            REQUIRE(hit.u == Approx(u).margin(1e-4));
+            REQUIRE(hit.v == Approx(v).margin(1e-4));
+            REQUIRE(hit.t == Approx(5.0f).margin(1e-4));
+        }
+    }
+
+    const kgfx::Ray<glm::vec3> miss{glm::vec3(-5.0f, 10.0f, 5.0f), glm::vec3(0.0f, -1.0f, 0.0f)};
+    kgfx::Patch_hit<float> hit;
+    REQUIRE_FALSE(kgfx::intersect(miss, patch, hit));
+
+    const kgfx::Ray<glm::vec3> away{glm::vec3(15.0f, 10.0f, 15.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+    REQUIRE_FALSE(kgfx::intersect(away, patch, hit));
+}
+
+TEST_CASE("Curve kernel benchmarks", "[.][benchmark]")
+{
+    const auto cubic = make_test_curve<3>();
+    const auto septic = make_test_curve<7>();
+    const auto t = make_test_parameters(10000);
+    std::vector<glm::vec3> out(t.size());
+
+    BENCHMARK("Bernstein sum, degree 3")
+    {
+        for (std::size_t i = 0; i < t.size(); ++i)
+        {
+            out[i] = kgfx::sample(cubic, t[i]);
+        }
+        return out.back();
+    };
+
+    BENCHMARK("Horner, degree 3")
+    {
+        kgfx::evaluate_horner<3>(cubic.data(), t.data(), out.data(), t.size());
+        return out.back();
+    };
+
+    BENCHMARK("de Casteljau, degree 3")
+    {
+        kgfx::evaluate_de_casteljau<3>(cubic.data(), t.data(), out.data(), t.size());
+        return out.back();
+    };
+
+    BENCHMARK("Horner, degree 7")
+    {
+        kgfx::evaluate_horner<7>(septic.data(), t.data(), out.data(), t.size());
+        return out.back();
+    };
+
+    BENCHMARK("de Casteljau, degree 7")
+    {
+        kgfx::evaluate_de_casteljau<7>(septic.data(), t.data(), out.data(), t.size());
+        return out.back();
+    };
+}
+
+namespace {
+
+    template <typename Point, typename T>
+    std::vector<Bezier_curve<Point, T, 4>> make_test_curves(std::size_t count)
+    {
+        std::vector<Bezier_curve<Point, T, 4>> curves;
+        curves.reserve(count);
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            const T phase = static_cast<T>(c) * T(0.37);
+            std::array<Point, 4> points;
+            std::array<T, 4> weights;
+            for (int i = 0; i < 4; ++i)
+            {
+                const T fi = static_cast<T>(i);
+                points[i] = Point(fi + phase, std::sin(fi + phase) * T(3), std::cos(fi * phase));
+                weights[i] = T(1) + T(0.5) * std::sin(phase + fi);
+            }
+            curves.emplace_back(points, weights);
+        }
+        return curves;
+    }
+
+    template <typename Point, typename T>
+    void check_curve_batch(T tolerance)
+    {
+        // Not a multiple of the lane count.
+        const auto curves = make_test_curves<Point, T>(37);
+
+        kgfx::Bezier_curve_batch<T, 4> batch;
+        for (const auto& curve : curves)
+        {
+            batch.add(curve);
+        }
+        REQUIRE(batch.size() == curves.size());
+
+        std::vector<T> t(curves.size());
+        for (std::size_t i = 0; i < t.size(); ++i)
+        {
+            t[i] = static_cast<T>(i) / static_cast<T>(t.size() - 1);
+        }
+
+        std::vector<Point> out(curves.size());
+        batch.evaluate(t.data(), out.data());
+        for (std::size_t i = 0; i < curves.size(); ++i)
+        {
+            REQUIRE(glm::length(out[i] - curves[i].sample(t[i])) < tolerance);
+        }
+
+        // One curve, many parameters.
+        std::vector<T> x(t.size());
+        std::vector<T> y(t.size());
+        std::vector<T> z(t.size());
+        batch.evaluate(5, t.data(), x.data(), y.data(), z.data(), t.size());
+        for (std::size_t i = 0; i < t.size(); ++i)
+        {
+            REQUIRE(glm::length(Point(x[i], y[i], z[i]) - curves[5].sample(t[i])) < tolerance);
+        }
+    }
+
+} // namespace
+
+TEST_CASE("Curve batch matches per curve sampling", "[bezier]")
+{
+    check_curve_batch<glm::vec3, float>(1e-4f);
+    check_curve_batch<glm::dvec3, double>(1e-10);
+}
+
+TEST_CASE("Curve batch benchmarks", "[.][benchmark]")
+{
+    const std::size_t count = 10000;
+    const auto curves = make_test_curves<glm::vec3, float>(count);
+    const auto curves_double = make_test_curves<glm::dvec3, double>(count);
+
+    kgfx::Bezier_curve_batch<float, 4> batch;
+    kgfx::Bezier_curve_batch<double, 4> batch_double;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        batch.add(curves[i]);
+        batch_double.add(curves_double[i]);
+    }
+
+    const auto t = make_test_parameters(count);
+    const std::vector<double> t_double(t.begin(), t.end());
+    std::vector<glm::vec3> out(count);
+    std::vector<glm::dvec3> out_double(count);
+
+    BENCHMARK("Bezier_curve::sample, float")
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = curves[i].sample(t[i]);
+        }
+        return out.back();
+    };
+
+    BENCHMARK("Bezier_curve_batch, float")
+    {
+        batch.evaluate(t.data(), out.data());
+        return out.back();
+    };
+
+    BENCHMARK("Bezier_curve::sample, double")
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out_double[i] = curves_double[i].sample(t_double[i]);
+        }
+        return out_double.back();
+    };
+
+    BENCHMARK("Bezier_curve_batch, double")
+    {
+        batch_double.evaluate(t_double.data(), out_double.data());
+        return out_double.back();
+    };
+}
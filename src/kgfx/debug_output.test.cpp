@@ -0,0 +1,50 @@
+#include <catch.hpp>
+#include <kgfx/opengl/debug_output.hpp>
+#include "headless_renderer.test.hpp"
+#include <atomic>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+TEST_CASE("Debug_output counts API errors", "[opengl]")
+{
+    auto renderer = kgfx_test::make_headless_renderer(16, 16, true);
+    if (!renderer) {
+        return;
+    }
+
+    GLint flags = 0;
+    ::glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    REQUIRE((flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0);
+
+    // Synchronous, so messages are in before the offending call returns.
+    kgfx::opengl::Debug_output output(kgfx::opengl::Debug_message::low, true);
+
+    std::atomic<int> num_handled{0};
+    GLuint last_id = 0;
+    output.set_handler([&](const kgfx::opengl::Debug_message& message) {
+        ++num_handled;
+        last_id = message.id;
+    });
+
+    // Not a capability: GL_INVALID_ENUM.
+    ::glEnable(GL_ARRAY_BUFFER);
+    REQUIRE(::glGetError() == GL_INVALID_ENUM);
+
+    kgfx::opengl::Debug_output::Stats stats = output.stats();
+    REQUIRE(stats.errors == 1);
+    REQUIRE(stats.by_source[kgfx::opengl::Debug_message::api] == 1);
+    REQUIRE(num_handled == 1);
+
+    // Muted by id, the same error goes unreported.
+    output.ignore(kgfx::opengl::Debug_message::api, GL_DEBUG_TYPE_ERROR, last_id);
+    output.reset_stats();
+
+    ::glEnable(GL_ARRAY_BUFFER);
+    REQUIRE(::glGetError() == GL_INVALID_ENUM);
+
+    stats = output.stats();
+    REQUIRE(stats.errors == 0);
+    REQUIRE(num_handled == 1);
+}
+
+#endif
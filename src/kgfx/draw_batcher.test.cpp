@@ -0,0 +1,105 @@
+#include <catch.hpp>
+#include <kgfx/opengl/draw_batcher.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "headless_renderer.test.hpp"
+#include <vector>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 450 core
+        #extension GL_ARB_shader_draw_parameters : require
+        layout(location = 0) in vec3 position;
+        layout(std430, binding = 0) readonly buffer Draw_transforms {
+            mat4 transforms[];
+        };
+        void main()
+        {
+            gl_Position = transforms[gl_DrawIDARB] * vec4(position, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 450 core
+        out vec4 color;
+        void main()
+        {
+            color = vec4(1.0, 0.0, 0.0, 1.0);
+        })";
+
+    // 'num_quads' quads side by side in x from 'x', each 'width' wide and
+    // covering all of y.
+    kgfx::Triangle_mesh<> make_quads(unsigned num_quads, float x, float width)
+    {
+        std::vector<float> vertices;
+        std::vector<int> indices;
+        for (unsigned i = 0; i < num_quads; ++i)
+        {
+            const float x0 = x + width * static_cast<float>(i);
+            const float x1 = x0 + width;
+            const float quad[] = { x0, -1.0f, 0.0f,
+                                   x1, -1.0f, 0.0f,
+                                   x1,  1.0f, 0.0f,
+                                   x0,  1.0f, 0.0f };
+            vertices.insert(vertices.end(), quad, quad + 12);
+
+            const int base = static_cast<int>(i * 4);
+            const int triangles[] = { base, base + 1, base + 2, base + 2, base + 3, base };
+            indices.insert(indices.end(), triangles, triangles + 6);
+        }
+
+        return kgfx::Triangle_mesh<>::import_raw(vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+
+} // namespace
+
+TEST_CASE("Draw_batcher draws meshes moved by defragmentation", "[opengl]")
+{
+    const unsigned size = 32;
+
+    auto renderer = kgfx_test::make_headless_renderer(size, size);
+    if (!renderer) {
+        return;
+    }
+
+    kgfx::opengl::State_cache::current().set_enabled(GL_CULL_FACE, false);
+
+    kgfx::opengl::Shader_program program(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                                         kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source));
+
+    // Room for exactly three quads.
+    kgfx::opengl::Mesh_pool pool(12, 18);
+    const auto first = pool.allocate(make_quads(1, 0.5f, 0.5f));
+    const auto left = pool.allocate(make_quads(1, -1.0f, 1.0f));
+    const auto third = pool.allocate(make_quads(1, 0.5f, 0.5f));
+
+    kgfx::opengl::Draw_batcher batcher(16);
+    batcher.add(program, pool, left, glm::mat4(1.0f));
+
+    // Two free quads, but not adjacent: allocating two more defragments,
+    // moving 'left' to the front of the buffers.
+    pool.free(first);
+    pool.free(third);
+    pool.allocate(make_quads(2, 0.5f, 0.25f));
+
+    ::glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    batcher.render();
+
+    REQUIRE(batcher.stats().num_draws == 1);
+    REQUIRE(batcher.stats().num_batches == 1);
+
+    std::vector<unsigned char> rgba;
+    renderer->read_pixels(rgba);
+
+    auto red = [&](unsigned x, unsigned y) {
+        return rgba[(y * size + x) * 4];
+    };
+
+    // Drawn where 'left' is now, not where it used to be.
+    REQUIRE(red(size / 4, size / 2) == 255);
+    REQUIRE(red(size - 2, size / 2) == 0);
+}
+
+#endif
@@ -0,0 +1,51 @@
+#include <catch.hpp>
+#include <kgfx/opengl/frame_profiler.hpp>
+#include "headless_renderer.test.hpp"
+
+#if defined(KGFX_HEADLESS_EGL)
+
+TEST_CASE("Frame_profiler keeps GPU times of queued frames", "[opengl]")
+{
+    auto renderer = kgfx_test::make_headless_renderer(16, 16);
+    if (!renderer) {
+        return;
+    }
+
+    kgfx::opengl::Frame_profiler profiler;
+    const auto section = profiler.add_section("clear");
+
+    auto run_frame = [&]() {
+        {
+            auto scope = profiler.scope(section);
+            ::glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        profiler.end_frame();
+    };
+
+    // As many frames as there are queries, none waited for.
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        run_frame();
+    }
+
+    REQUIRE(profiler.sections()[0].cpu_ms.size() == 4);
+
+    // Every result is collected once in, none dropped.
+    ::glFinish();
+    profiler.end_frame();
+    REQUIRE(profiler.sections()[0].cpu_ms.size() == 4);
+    REQUIRE(profiler.sections()[0].gpu_ms.size() == 4);
+
+    for (int frame = 0; frame < 8; ++frame)
+    {
+        run_frame();
+        ::glFinish();
+    }
+
+    profiler.end_frame();
+    REQUIRE(profiler.sections()[0].cpu_ms.size() == 12);
+    REQUIRE(profiler.sections()[0].gpu_ms.size() == 12);
+}
+
+#endif
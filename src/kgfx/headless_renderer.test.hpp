@@ -0,0 +1,33 @@
+#pragma once
+#include <catch.hpp>
+#include <kgfx/opengl/renderer.hpp>
+#include <memory>
+#include <stdexcept>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace kgfx_test {
+
+    // A headless renderer for OpenGL tests. Null, with a warning, on machines
+    // with libEGL but no usable driver; tests skip themselves then.
+    inline std::unique_ptr<kgfx::opengl::Renderer> make_headless_renderer(unsigned width,
+                                                                          unsigned height,
+                                                                          bool debug_context = false)
+    {
+        auto renderer = std::make_unique<kgfx::opengl::Renderer>();
+        try
+        {
+            renderer->construct_headless(width, height, debug_context);
+        }
+        catch (const std::runtime_error& e)
+        {
+            WARN("Skipped, no headless OpenGL: " << e.what());
+            return nullptr;
+        }
+
+        return renderer;
+    }
+
+} // namespace kgfx_test
+
+#endif
@@ -0,0 +1,112 @@
+#include <catch.hpp>
+#include <kgfx/opengl/instance_buffer.hpp>
+#include <kgfx/opengl/mesh.hpp>
+#include <kgfx/opengl/shader.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "headless_renderer.test.hpp"
+#include <vector>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        layout(location = 3) in mat4 transform;
+        layout(location = 7) in vec3 instance_color;
+        out vec3 color;
+        void main()
+        {
+            color = instance_color;
+            gl_Position = transform * vec4(position, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 330 core
+        in vec3 color;
+        out vec4 fragment;
+        void main()
+        {
+            fragment = vec4(color, 1.0);
+        })";
+
+    // Square of side 0.5 around the origin.
+    kgfx::Triangle_mesh<> make_square()
+    {
+        const float vertices[] = { -0.25f, -0.25f, 0.0f,
+                                    0.25f, -0.25f, 0.0f,
+                                    0.25f,  0.25f, 0.0f,
+                                   -0.25f,  0.25f, 0.0f };
+        const int indices[] = { 0, 1, 2, 2, 3, 0 };
+
+        return kgfx::Triangle_mesh<>::import_raw(vertices, 12, indices, 6);
+    }
+
+} // namespace
+
+TEST_CASE("Instanced draws", "[opengl]")
+{
+    const unsigned size = 32;
+
+    auto renderer = kgfx_test::make_headless_renderer(size, size);
+    if (!renderer) {
+        return;
+    }
+
+    auto& state = kgfx::opengl::State_cache::current();
+    state.set_enabled(GL_CULL_FACE, false);
+
+    kgfx::opengl::Shader_program program(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                                         kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source));
+    kgfx::opengl::Mesh mesh(make_square());
+
+    // One square per quadrant, red increasing with the index.
+    const glm::vec2 centers[] = { {-0.5f, -0.5f}, {0.5f, -0.5f}, {-0.5f, 0.5f}, {0.5f, 0.5f} };
+
+    kgfx::Instance_builder builder(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        kgfx::Instance instance;
+        instance.transform[3] = glm::vec4(centers[i].x, centers[i].y, 0.0f, 1.0f);
+        instance.color = glm::vec3(0.25f * static_cast<float>(i + 1), 0.0f, 0.0f);
+        builder.push_back(instance);
+    }
+
+    kgfx::opengl::Instance_buffer instances;
+    instances.upload(builder);
+    REQUIRE(instances.size() == 4);
+
+    std::vector<unsigned char> rgba;
+    auto red = [&](unsigned x, unsigned y) {
+        return static_cast<int>(rgba[(y * size + x) * 4]);
+    };
+
+    program.bind();
+
+    ::glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    mesh.render_instanced(instances, 1, 3);
+    renderer->read_pixels(rgba);
+
+    REQUIRE(red(size / 4, size / 4) == 0);
+    REQUIRE(red(3 * size / 4, size / 4) == Approx(128).margin(1));
+    REQUIRE(red(size / 4, 3 * size / 4) == Approx(191).margin(1));
+    REQUIRE(red(3 * size / 4, 3 * size / 4) == 255);
+
+    // Later draws only rebind the buffer, here with new contents.
+    builder.clear();
+    kgfx::Instance instance;
+    instance.color = glm::vec3(1.0f, 0.0f, 0.0f);
+    builder.push_back(instance);
+    instances.upload(builder);
+
+    ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    mesh.render_instanced(instances);
+    renderer->read_pixels(rgba);
+
+    REQUIRE(red(size / 2, size / 2) == 255);
+    REQUIRE(red(size / 4, size / 4) == 0);
+}
+
+#endif
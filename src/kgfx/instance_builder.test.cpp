@@ -0,0 +1,60 @@
+#include <catch.hpp>
+#include <kgfx/instance_builder.hpp>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Instance builder filled from several threads", "[instance_builder]")
+{
+    const std::size_t num_threads = 4;
+    const std::size_t per_thread = 1000;
+    const std::size_t batch = 10;
+
+    kgfx::Instance_builder builder(num_threads * per_thread);
+
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < num_threads; ++w)
+    {
+        workers.emplace_back([&builder, w]() {
+            for (std::size_t i = 0; i < per_thread; i += batch)
+            {
+                kgfx::Instance* slice = builder.allocate(batch);
+                for (std::size_t j = 0; j < batch; ++j)
+                {
+                    slice[j].color = glm::vec3(static_cast<float>(w), static_cast<float>(i + j), 0.0f);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    REQUIRE(builder.size() == builder.capacity());
+
+    // Every (thread, index) written exactly once, so the slices were disjoint.
+    std::vector<int> seen(num_threads * per_thread, 0);
+    for (std::size_t i = 0; i < builder.size(); ++i)
+    {
+        const glm::vec3& color = builder.data()[i].color;
+        ++seen[static_cast<std::size_t>(color.x) * per_thread + static_cast<std::size_t>(color.y)];
+    }
+
+    for (int count : seen)
+    {
+        REQUIRE(count == 1);
+    }
+
+    SECTION("Full builder refuses more")
+    {
+        REQUIRE(builder.allocate(1) == nullptr);
+        REQUIRE(!builder.push_back(kgfx::Instance()));
+        REQUIRE(builder.size() == builder.capacity());
+
+        builder.clear();
+        REQUIRE(builder.size() == 0);
+        REQUIRE(builder.push_back(kgfx::Instance()));
+        REQUIRE(builder.size() == 1);
+    }
+}
@@ -0,0 +1,278 @@
+#include <catch.hpp>
+#include <kgfx/bezier.hpp>
+#include <kgfx/mesh_generator.hpp>
+#include "headless_renderer.test.hpp"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+    struct Generated {
+        std::vector<kgfx::Vertex> vertices;
+        std::vector<kgfx::Triangle> triangles;
+    };
+
+    // Runs 'generator' into storage of exactly size(), plus one guard
+    // element each, and checks that everything and only that was written.
+    template <typename Generator>
+    Generated generate_checked(const Generator& generator, unsigned base_vertex)
+    {
+        const kgfx::Mesh_size size = generator.size();
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+
+        kgfx::Vertex unwritten;
+        unwritten.position = glm::vec3(nan);
+
+        Generated out;
+        out.vertices.assign(size.num_vertices + 1, unwritten);
+        out.triangles.assign(size.num_triangles + 1, kgfx::Triangle());
+
+        generator.generate(out.vertices.data(), out.triangles.data(), base_vertex);
+
+        REQUIRE(std::isnan(out.vertices.back().position.x));
+        REQUIRE(out.triangles.back().v0 == ~0u);
+        out.vertices.pop_back();
+        out.triangles.pop_back();
+
+        for (const auto& v : out.vertices)
+        {
+            REQUIRE_FALSE(std::isnan(v.position.x));
+        }
+
+        for (auto& t : out.triangles)
+        {
+            for (unsigned index : {t.v0, t.v1, t.v2})
+            {
+                REQUIRE(index >= base_vertex);
+                REQUIRE(index < base_vertex + size.num_vertices);
+            }
+
+            t = t.offset(0u - base_vertex);
+        }
+
+        return out;
+    }
+
+    // Unit normals, and triangles wound so cross(v1 - v0, v2 - v0) points
+    // along them: clockwise seen from the front in kgfx's left handed,
+    // glFrontFace(GL_CW) convention. Zero area triangles are skipped.
+    void check_normals_and_winding(const Generated& mesh)
+    {
+        for (const auto& v : mesh.vertices)
+        {
+            REQUIRE(glm::length(v.normal) == Approx(1.0f).margin(1e-5f));
+        }
+
+        for (const auto& t : mesh.triangles)
+        {
+            const glm::vec3& a = mesh.vertices[t.v0].position;
+            const glm::vec3& b = mesh.vertices[t.v1].position;
+            const glm::vec3& c = mesh.vertices[t.v2].position;
+
+            const glm::vec3 face = glm::cross(b - a, c - a);
+            if (glm::length(face) < 1e-6f) {
+                continue;
+            }
+
+            const glm::vec3 normal = mesh.vertices[t.v0].normal
+                                     + mesh.vertices[t.v1].normal
+                                     + mesh.vertices[t.v2].normal;
+            REQUIRE(glm::dot(face, normal) > 0.0f);
+        }
+    }
+
+    kgfx::Bezier_patch<glm::vec3, float> make_test_patch()
+    {
+        std::array<glm::vec3, 16> points;
+        for (int j = 0; j < 4; ++j)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                const float height = static_cast<float>((i * 7 + j * 3) % 5) - 2.0f;
+                points[i + j * 4] = glm::vec3(static_cast<float>(i), height * 0.1f, static_cast<float>(j));
+            }
+        }
+
+        return kgfx::Bezier_patch<glm::vec3, float>(points);
+    }
+
+} // namespace
+
+TEST_CASE("Grid_generator", "[mesh_generator]")
+{
+    const Generated grid = generate_checked(kgfx::Grid_generator(5, 3, glm::vec2(4.0f, 2.0f)), 7);
+
+    REQUIRE(grid.vertices.size() == 15);
+    REQUIRE(grid.triangles.size() == 16);
+    check_normals_and_winding(grid);
+
+    for (const auto& v : grid.vertices)
+    {
+        REQUIRE(v.position.y == 0.0f);
+        REQUIRE(std::abs(v.position.x) <= 2.0f);
+        REQUIRE(std::abs(v.position.z) <= 1.0f);
+    }
+}
+
+TEST_CASE("Box_generator", "[mesh_generator]")
+{
+    const glm::vec3 half_extents(1.0f, 2.0f, 3.0f);
+    const Generated box = generate_checked(kgfx::Box_generator(half_extents), 3);
+
+    REQUIRE(box.vertices.size() == 24);
+    REQUIRE(box.triangles.size() == 12);
+    check_normals_and_winding(box);
+
+    // Every vertex is a corner, lying on the face of its normal.
+    for (const auto& v : box.vertices)
+    {
+        REQUIRE(std::abs(v.position.x) == half_extents.x);
+        REQUIRE(std::abs(v.position.y) == half_extents.y);
+        REQUIRE(std::abs(v.position.z) == half_extents.z);
+        REQUIRE(glm::dot(v.position, v.normal) > 0.0f);
+    }
+}
+
+TEST_CASE("Sphere_generator", "[mesh_generator]")
+{
+    const float radius = 2.0f;
+    const Generated sphere = generate_checked(kgfx::Sphere_generator(radius, 12, 6), 1);
+
+    REQUIRE(sphere.vertices.size() == 13 * 7);
+    REQUIRE(sphere.triangles.size() == 12 * 6 * 2);
+    check_normals_and_winding(sphere);
+
+    for (const auto& v : sphere.vertices)
+    {
+        REQUIRE(glm::length(v.position) == Approx(radius));
+        REQUIRE(v.position.x == Approx(v.normal.x * radius).margin(1e-5f));
+        REQUIRE(v.position.y == Approx(v.normal.y * radius).margin(1e-5f));
+        REQUIRE(v.position.z == Approx(v.normal.z * radius).margin(1e-5f));
+    }
+}
+
+TEST_CASE("Patch_generator matches make_patch", "[mesh_generator]")
+{
+    const auto patch = make_test_patch();
+    const unsigned num_x = 6;
+    const unsigned num_y = 4;
+
+    for (auto sampling : {kgfx::Patch_sampling::basis_tables, kgfx::Patch_sampling::forward_differences})
+    {
+        for (auto normals : {kgfx::Patch_normals::none, kgfx::Patch_normals::analytic})
+        {
+            kgfx::Triangle_mesh<> mesh;
+            mesh.make_patch(patch, num_x, num_y, sampling, normals);
+
+            const Generated generated = generate_checked(
+                kgfx::Patch_generator<decltype(patch)>(patch, num_x, num_y, sampling, normals), 2);
+
+            REQUIRE(mesh.vertices.size() == generated.vertices.size());
+            REQUIRE(mesh.triangles.size() == generated.triangles.size());
+
+            for (std::size_t i = 0; i < mesh.triangles.size(); ++i)
+            {
+                REQUIRE(mesh.triangles[i].v0 == generated.triangles[i].v0);
+                REQUIRE(mesh.triangles[i].v1 == generated.triangles[i].v1);
+                REQUIRE(mesh.triangles[i].v2 == generated.triangles[i].v2);
+            }
+
+            for (unsigned y = 0; y < num_y; ++y)
+            {
+                for (unsigned x = 0; x < num_x; ++x)
+                {
+                    const std::size_t i = x + y * num_x;
+                    const float tx = static_cast<float>(x) / static_cast<float>(num_x - 1);
+                    const float ty = static_cast<float>(y) / static_cast<float>(num_y - 1);
+                    const glm::vec3 expected = patch.sample(tx, ty);
+
+                    REQUIRE(mesh.vertices[i].position.x == generated.vertices[i].position.x);
+                    REQUIRE(mesh.vertices[i].position.y == generated.vertices[i].position.y);
+                    REQUIRE(mesh.vertices[i].position.z == generated.vertices[i].position.z);
+                    REQUIRE(glm::length(generated.vertices[i].position - expected) < 1e-4f);
+
+                    if (normals == kgfx::Patch_normals::analytic) {
+                        REQUIRE(glm::length(generated.vertices[i].normal - patch.normal(tx, ty)) < 1e-4f);
+                    }
+                }
+            }
+
+            if (normals == kgfx::Patch_normals::analytic) {
+                check_normals_and_winding(generated);
+            }
+        }
+    }
+}
+
+#if defined(KGFX_HEADLESS_EGL)
+
+#include <kgfx/opengl/mesh.hpp>
+#include <kgfx/opengl/shader.hpp>
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        layout(location = 1) in vec3 normal;
+        out vec3 color;
+        void main()
+        {
+            color = abs(normal);
+            gl_Position = vec4(position.xy, position.z * 0.5, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 330 core
+        in vec3 color;
+        out vec4 fragment;
+        void main()
+        {
+            fragment = vec4(color, 1.0);
+        })";
+
+} // namespace
+
+TEST_CASE("Mesh::load_generated draws like a loaded Triangle_mesh", "[opengl]")
+{
+    const unsigned size = 32;
+
+    auto renderer = kgfx_test::make_headless_renderer(size, size);
+    if (!renderer) {
+        return;
+    }
+
+    kgfx::opengl::Shader_program program(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                                         kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source));
+    program.bind();
+
+    const kgfx::Sphere_generator generator(0.8f, 16, 8);
+
+    auto draw = [&](kgfx::opengl::Mesh& mesh) {
+        std::vector<unsigned char> rgba;
+        ::glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mesh.render();
+        renderer->read_pixels(rgba);
+        return rgba;
+    };
+
+    kgfx::Triangle_mesh<> source;
+    source.generate(generator);
+    kgfx::opengl::Mesh loaded(source);
+
+    kgfx::opengl::Mesh generated;
+    generated.load_generated(generator);
+    REQUIRE(generated);
+
+    const std::vector<unsigned char> expected = draw(loaded);
+    const std::vector<unsigned char> actual = draw(generated);
+
+    REQUIRE(expected[(size / 2 * size + size / 2) * 4 + 3] == 255);
+    REQUIRE(expected[(size / 2 * size + size / 2) * 4 + 2] > 0);
+    REQUIRE(actual == expected);
+}
+
+#endif
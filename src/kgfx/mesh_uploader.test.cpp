@@ -0,0 +1,114 @@
+#include <catch.hpp>
+#include <kgfx/opengl/mesh_uploader.hpp>
+#include <kgfx/opengl/shader.hpp>
+#include <kgfx/mesh_generator.hpp>
+#include "headless_renderer.test.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        layout(location = 1) in vec3 normal;
+        out vec3 color;
+        void main()
+        {
+            color = abs(normal);
+            gl_Position = vec4(position.xy, position.z * 0.5, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 330 core
+        in vec3 color;
+        out vec4 fragment;
+        void main()
+        {
+            fragment = vec4(color, 1.0);
+        })";
+
+} // namespace
+
+TEST_CASE("Mesh_uploader spreads uploads over frames", "[opengl]")
+{
+    const unsigned size = 32;
+
+    auto renderer = kgfx_test::make_headless_renderer(size, size);
+    if (!renderer) {
+        return;
+    }
+
+    kgfx::opengl::Shader_program program(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                                         kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source));
+
+    const kgfx::Sphere_generator generator(0.8f, 16, 8);
+    const kgfx::Mesh_size mesh_size = generator.size();
+    const std::size_t mesh_bytes = sizeof(kgfx::Vertex) * mesh_size.num_vertices
+                                   + sizeof(kgfx::Triangle) * mesh_size.num_triangles;
+
+    const GLsizeiptr budget = 1024;
+    REQUIRE(mesh_bytes > 4 * budget);
+
+    kgfx::opengl::Mesh_uploader uploader(budget, 2);
+    const auto sphere = uploader.submit_generator(generator);
+    const auto broken = uploader.submit([]() -> kgfx::Triangle_mesh<> {
+        throw std::runtime_error("Unreadable mesh.");
+    });
+
+    std::size_t bytes_uploaded = 0;
+    unsigned num_upload_frames = 0;
+    for (unsigned frame = 0; frame < 1000 && !(uploader.is_ready(sphere) && uploader.is_ready(broken)); ++frame)
+    {
+        // Nothing is ready before all of it has been copied.
+        REQUIRE((bytes_uploaded == mesh_bytes || !uploader.is_ready(sphere)));
+
+        uploader.update();
+
+        const std::size_t bytes = uploader.stats().bytes_uploaded;
+        REQUIRE(bytes <= static_cast<std::size_t>(budget));
+        if (bytes > 0) {
+            ++num_upload_frames;
+        }
+
+        bytes_uploaded += bytes;
+
+        // Leaves the workers time, as a real frame would.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(uploader.is_ready(sphere));
+    REQUIRE(uploader.is_ready(broken));
+    REQUIRE(bytes_uploaded == mesh_bytes);
+    REQUIRE(num_upload_frames >= mesh_bytes / budget);
+
+    REQUIRE_THROWS_AS(uploader.take(broken), std::runtime_error);
+
+    kgfx::opengl::Mesh uploaded = uploader.take(sphere);
+    REQUIRE(uploaded);
+
+    // Same pixels as the mesh loaded synchronously.
+    kgfx::Triangle_mesh<> source;
+    source.generate(generator);
+    kgfx::opengl::Mesh loaded(source);
+
+    program.bind();
+    auto draw = [&](kgfx::opengl::Mesh& mesh) {
+        std::vector<unsigned char> rgba;
+        ::glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mesh.render();
+        renderer->read_pixels(rgba);
+        return rgba;
+    };
+
+    const std::vector<unsigned char> expected = draw(loaded);
+    REQUIRE(expected[(size / 2 * size + size / 2) * 4 + 3] == 255);
+    REQUIRE(draw(uploaded) == expected);
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include <catch.hpp>
+#include <kgfx/occlusion_culler.hpp>
+#include <vector>
+
+namespace {
+
+    // Square in the xy plane at depth 'z'.
+    kgfx::Triangle_mesh<> make_quad(float half_size, float z)
+    {
+        const float vertices[] = {
+            -half_size, -half_size, z,
+             half_size, -half_size, z,
+             half_size,  half_size, z,
+            -half_size,  half_size, z,
+        };
+        const int indices[] = {0, 1, 2, 2, 3, 0};
+
+        return kgfx::Triangle_mesh<>::import_raw(vertices, 12, indices, 6);
+    }
+
+    using Box = kgfx::Bounding_box<glm::vec3>;
+
+} // namespace
+
+TEST_CASE("Occlusion in clip space", "[occlusion_culler]")
+{
+    const glm::mat4 identity(1.0f);
+
+    kgfx::Occlusion_culler culler(64, 64);
+    culler.add_occluder(make_quad(0.5f, 0.0f), identity);
+    culler.build();
+
+    REQUIRE(culler.depth(32, 32) == Approx(0.5f));
+    REQUIRE(culler.depth(2, 2) == 1.0f);
+
+    // Behind the quad.
+    REQUIRE_FALSE(culler.is_visible(Box(glm::vec3(-0.2f, -0.2f, 0.2f), glm::vec3(0.2f, 0.2f, 0.4f)), identity));
+
+    // In front of it.
+    REQUIRE(culler.is_visible(Box(glm::vec3(-0.2f, -0.2f, -0.4f), glm::vec3(0.2f, 0.2f, -0.2f)), identity));
+
+    // Behind, but sticking out over the edge.
+    REQUIRE(culler.is_visible(Box(glm::vec3(0.3f, -0.2f, 0.2f), glm::vec3(0.7f, 0.2f, 0.4f)), identity));
+
+    // Partly outside the buffer.
+    REQUIRE(culler.is_visible(Box(glm::vec3(0.9f, -0.2f, 0.2f), glm::vec3(1.2f, 0.2f, 0.4f)), identity));
+
+    REQUIRE(culler.stats().num_occluder_triangles == 2);
+    REQUIRE(culler.stats().num_tested == 4);
+    REQUIRE(culler.stats().num_culled == 1);
+
+    culler.clear();
+    culler.build();
+    REQUIRE(culler.is_visible(Box(glm::vec3(-0.2f, -0.2f, 0.2f), glm::vec3(0.2f, 0.2f, 0.4f)), identity));
+}
+
+TEST_CASE("Occlusion behind a wall", "[occlusion_culler]")
+{
+    const glm::mat4 view_projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f)
+                                      * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    kgfx::Occlusion_culler culler;
+    culler.add_occluder(make_quad(5.0f, 10.0f), view_projection);
+    culler.build();
+
+    const std::vector<Box> boxes = {
+        Box(glm::vec3(-1.0f, -1.0f, 19.0f), glm::vec3(1.0f, 1.0f, 21.0f)),  // Behind the wall.
+        Box(glm::vec3(-1.0f, -1.0f, 4.0f), glm::vec3(1.0f, 1.0f, 6.0f)),    // In front.
+        Box(glm::vec3(30.0f, -1.0f, 19.0f), glm::vec3(32.0f, 1.0f, 21.0f)), // Beside it.
+        Box(glm::vec3(-1.0f, -1.0f, -6.0f), glm::vec3(1.0f, 1.0f, -4.0f)),  // Behind the camera.
+    };
+
+    std::vector<bool> visible;
+    culler.cull(boxes, view_projection, visible);
+
+    REQUIRE(visible == std::vector<bool>{false, true, true, true});
+    REQUIRE(culler.stats().num_culled == 1);
+    REQUIRE(culler.stats().test_ms >= 0.0);
+}
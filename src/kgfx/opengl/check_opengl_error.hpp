@@ -5,6 +5,7 @@
 
 namespace kgfx {
 
+#if defined(KGFX_GL_ERROR_POLLING)
     inline void check_opengl_error()
     {
         const GLenum error = ::glGetError();
@@ -15,5 +16,12 @@ namespace kgfx {
             throw std::runtime_error(std::string("OpenGL error: ") + str);
         }
     }
+#else
+    // Compiled out: glGetError can stall the pipeline. Use
+    // opengl::Debug_output to have errors reported instead.
+    inline void check_opengl_error()
+    {
+    }
+#endif
 
 } // namespace kgfx
@@ -0,0 +1,180 @@
+#include <kgfx/opengl/debug_output.hpp>
+#include <cstdio>
+#include <stdexcept>
+
+namespace kgfx {
+namespace opengl {
+
+    namespace {
+
+        const GLenum gl_sources[] = { GL_DEBUG_SOURCE_API,
+                                      GL_DEBUG_SOURCE_WINDOW_SYSTEM,
+                                      GL_DEBUG_SOURCE_SHADER_COMPILER,
+                                      GL_DEBUG_SOURCE_THIRD_PARTY,
+                                      GL_DEBUG_SOURCE_APPLICATION,
+                                      GL_DEBUG_SOURCE_OTHER };
+
+        const GLenum gl_severities[] = { GL_DEBUG_SEVERITY_NOTIFICATION,
+                                         GL_DEBUG_SEVERITY_LOW,
+                                         GL_DEBUG_SEVERITY_MEDIUM,
+                                         GL_DEBUG_SEVERITY_HIGH };
+
+        const char* const source_names[] = { "api",
+                                              "window system",
+                                              "shader compiler",
+                                              "third party",
+                                              "application",
+                                              "other" };
+
+        const char* const severity_names[] = { "notification",
+                                               "low",
+                                               "medium",
+                                               "high" };
+
+        Debug_message::Source to_source(GLenum source)
+        {
+            for (int i = 0; i < Debug_message::num_sources; ++i)
+            {
+                if (gl_sources[i] == source) {
+                    return static_cast<Debug_message::Source>(i);
+                }
+            }
+
+            return Debug_message::other;
+        }
+
+        Debug_message::Severity to_severity(GLenum severity)
+        {
+            for (int i = 0; i < Debug_message::num_severities; ++i)
+            {
+                if (gl_severities[i] == severity) {
+                    return static_cast<Debug_message::Severity>(i);
+                }
+            }
+
+            return Debug_message::high;
+        }
+
+    } // namespace
+
+    Debug_output::Debug_output(Debug_message::Severity min_severity, bool synchronous)
+    {
+        if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) {
+            throw std::runtime_error("Debug output needs OpenGL 4.3 or KHR_debug.");
+        }
+
+        ::glEnable(GL_DEBUG_OUTPUT);
+        if (synchronous) {
+            ::glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+        else {
+            ::glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+
+        ::glDebugMessageCallback(callback, this);
+
+        // Filter in the driver, so muted messages are not even formatted.
+        for (int i = 0; i < Debug_message::num_severities; ++i)
+        {
+            ::glDebugMessageControl(GL_DONT_CARE,
+                                    GL_DONT_CARE,
+                                    gl_severities[i],
+                                    0,
+                                    nullptr,
+                                    i >= min_severity ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    Debug_output::~Debug_output()
+    {
+        ::glDebugMessageCallback(nullptr, nullptr);
+        ::glDisable(GL_DEBUG_OUTPUT);
+    }
+
+    void Debug_output::set_handler(Handler handler)
+    {
+        std::lock_guard<std::mutex> lock(handler_mutex_);
+        handler_ = std::move(handler);
+    }
+
+    void Debug_output::ignore(Debug_message::Source source, GLenum type, GLuint id)
+    {
+        ::glDebugMessageControl(gl_sources[source], type, GL_DONT_CARE, 1, &id, GL_FALSE);
+    }
+
+    Debug_output::Stats Debug_output::stats() const
+    {
+        Stats s;
+        for (std::size_t i = 0; i < s.by_source.size(); ++i)
+        {
+            s.by_source[i] = by_source_[i].load(std::memory_order_relaxed);
+        }
+
+        for (std::size_t i = 0; i < s.by_severity.size(); ++i)
+        {
+            s.by_severity[i] = by_severity_[i].load(std::memory_order_relaxed);
+        }
+
+        s.errors = errors_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void Debug_output::reset_stats()
+    {
+        for (auto& count : by_source_)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        for (auto& count : by_severity_)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        errors_.store(0, std::memory_order_relaxed);
+    }
+
+    void Debug_output::write_to_stderr(const Debug_message& message)
+    {
+        std::fprintf(stderr,
+                     "OpenGL %s (%s, %u): %s\n",
+                     source_names[message.source],
+                     severity_names[message.severity],
+                     message.id,
+                     message.text);
+    }
+
+    void GLAPIENTRY Debug_output::callback(GLenum source,
+                                           GLenum type,
+                                           GLuint id,
+                                           GLenum severity,
+                                           GLsizei /*length*/,
+                                           const GLchar* text,
+                                           const void* user_param)
+    {
+        Debug_message message;
+        message.source = to_source(source);
+        message.severity = to_severity(severity);
+        message.type = type;
+        message.id = id;
+        message.text = text;
+
+        static_cast<Debug_output*>(const_cast<void*>(user_param))->receive(message);
+    }
+
+    void Debug_output::receive(const Debug_message& message)
+    {
+        by_source_[message.source].fetch_add(1, std::memory_order_relaxed);
+        by_severity_[message.severity].fetch_add(1, std::memory_order_relaxed);
+        if (GL_DEBUG_TYPE_ERROR == message.type) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(handler_mutex_);
+        if (handler_) {
+            handler_(message);
+        }
+    }
+
+} // namespace opengl
+} // namespace kgfx
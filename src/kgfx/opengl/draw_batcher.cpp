@@ -0,0 +1,118 @@
+#include <kgfx/opengl/draw_batcher.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "check_opengl_error.hpp"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace kgfx {
+namespace opengl {
+
+    Draw_batcher::Draw_batcher(std::size_t max_draws, unsigned num_frames)
+        : max_draws_{max_draws}
+    {
+        static_assert(sizeof(Draw_elements_indirect_command) == 5 * sizeof(GLuint), "Indirect command layout.");
+
+        GLint alignment = 0;
+        ::glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0) {
+            storage_alignment_ = alignment;
+        }
+
+        // Worst case every draw is its own batch, each aligned.
+        command_stream_ = Stream_buffer(sizeof(Draw_elements_indirect_command) * max_draws, num_frames);
+        transform_stream_ = Stream_buffer((sizeof(glm::mat4) + storage_alignment_) * max_draws, num_frames);
+
+        draws_.reserve(max_draws);
+    }
+
+    void Draw_batcher::add(Shader_program& shader,
+                           const Mesh_pool& pool,
+                           Mesh_pool::Mesh_id mesh,
+                           const glm::mat4& transform)
+    {
+        if (draws_.size() == max_draws_) {
+            throw std::runtime_error("Too many draws for the batcher.");
+        }
+
+        Draw draw;
+        draw.shader = &shader;
+        draw.pool = &pool;
+        draw.mesh = mesh;
+        draw.transform = transform;
+        draws_.push_back(draw);
+    }
+
+    void Draw_batcher::render()
+    {
+        stats_ = Stats();
+        if (draws_.empty()) {
+            return;
+        }
+
+        std::stable_sort(draws_.begin(), draws_.end(), [](const Draw& a, const Draw& b) {
+            return a.shader != b.shader ? a.shader < b.shader : a.pool < b.pool;
+        });
+
+        command_stream_.begin_frame();
+        transform_stream_.begin_frame();
+
+        State_cache::current().bind_buffer(GL_DRAW_INDIRECT_BUFFER, command_stream_.handle());
+
+        for (std::size_t first = 0; first < draws_.size();)
+        {
+            std::size_t last = first + 1;
+            while (last < draws_.size()
+                   && draws_[last].shader == draws_[first].shader
+                   && draws_[last].pool == draws_[first].pool)
+            {
+                ++last;
+            }
+
+            const std::size_t count = last - first;
+            const GLsizeiptr command_bytes = sizeof(Draw_elements_indirect_command) * count;
+            const GLsizeiptr transform_bytes = sizeof(glm::mat4) * count;
+
+            const Stream_allocation commands = command_stream_.allocate(command_bytes, sizeof(GLuint));
+            const Stream_allocation transforms = transform_stream_.allocate(transform_bytes, storage_alignment_);
+            assert(commands.data && transforms.data);
+
+            auto* command = static_cast<Draw_elements_indirect_command*>(commands.data);
+            auto* transform = static_cast<glm::mat4*>(transforms.data);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                command[i] = draws_[first + i].pool->draw_command(draws_[first + i].mesh);
+                command[i].base_instance = static_cast<GLuint>(i);
+                transform[i] = draws_[first + i].transform;
+            }
+
+            draws_[first].shader->bind();
+            draws_[first].pool->bind();
+            transform_stream_.bind_range(GL_SHADER_STORAGE_BUFFER, transform_binding, transforms, transform_bytes);
+
+            ::glMultiDrawElementsIndirect(GL_TRIANGLES,
+                                          GL_UNSIGNED_INT,
+                                          reinterpret_cast<const GLvoid*>(commands.offset),
+                                          static_cast<GLsizei>(count),
+                                          0);
+
+            ++stats_.num_batches;
+            first = last;
+        }
+
+        command_stream_.end_frame();
+        transform_stream_.end_frame();
+
+        check_opengl_error();
+
+        stats_.num_draws = draws_.size();
+        draws_.clear();
+    }
+
+    const Draw_batcher::Stats& Draw_batcher::stats() const
+    {
+        return stats_;
+    }
+
+} // namespace opengl
+} // namespace kgfx
@@ -0,0 +1,180 @@
+#include <kgfx/opengl/frame_profiler.hpp>
+#include "check_opengl_error.hpp"
+#include <cassert>
+#include <cstdio>
+
+namespace kgfx {
+namespace opengl {
+
+    Frame_profiler::Scope::Scope(Frame_profiler* profiler, Section section)
+        : profiler_(profiler)
+        , section_(section)
+    {
+        profiler_->begin(section_);
+    }
+
+    Frame_profiler::Scope::Scope(Scope&& rhs) noexcept
+        : profiler_(rhs.profiler_)
+        , section_(rhs.section_)
+    {
+        rhs.profiler_ = nullptr;
+    }
+
+    Frame_profiler::Scope::~Scope()
+    {
+        if (profiler_) {
+            profiler_->end(section_);
+        }
+    }
+
+    Frame_profiler::Frame_profiler(std::size_t window)
+        : window_(window)
+    {
+    }
+
+    Frame_profiler::~Frame_profiler()
+    {
+        release();
+    }
+
+    void Frame_profiler::release()
+    {
+        for (auto& timing : timings_)
+        {
+            assert(!timing.active);
+
+            if (timing.queries[0] != 0) {
+                ::glDeleteQueries(num_queries, timing.queries.data());
+                timing.queries.fill(0);
+            }
+
+            timing.pending.fill(false);
+            timing.next = 0;
+        }
+    }
+
+    Frame_profiler::Section Frame_profiler::add_section(const std::string& name)
+    {
+        Section_stats stats{name, Rolling_stat(window_), Rolling_stat(window_)};
+        sections_.push_back(std::move(stats));
+        timings_.emplace_back();
+
+        return static_cast<Section>(sections_.size() - 1);
+    }
+
+    void Frame_profiler::begin(Section section)
+    {
+        assert(section < timings_.size());
+
+        Timing& timing = timings_[section];
+        assert(!timing.active);
+        assert(!timing.ran && "Sections run at most once per frame.");
+
+        // Created on first use, the profiler may exist before the context.
+        if (0 == timing.queries[0]) {
+            ::glGenQueries(num_queries, timing.queries.data());
+        }
+
+        // Results come in order, so the next slot is the last to free up.
+        timing.gpu_timed = !timing.pending[timing.next];
+        if (timing.gpu_timed)
+        {
+            ::glBeginQuery(GL_TIME_ELAPSED, timing.queries[timing.next]);
+            timing.pending[timing.next] = true;
+            timing.next = (timing.next + 1) % num_queries;
+        }
+
+        timing.active = true;
+        timing.ran = true;
+        timing.cpu_begin = Clock::now();
+    }
+
+    void Frame_profiler::end(Section section)
+    {
+        assert(section < timings_.size());
+
+        Timing& timing = timings_[section];
+        assert(timing.active);
+
+        timing.cpu_ms = std::chrono::duration<double, std::milli>(Clock::now() - timing.cpu_begin).count();
+        timing.active = false;
+
+        if (timing.gpu_timed) {
+            ::glEndQuery(GL_TIME_ELAPSED);
+        }
+    }
+
+    Frame_profiler::Scope Frame_profiler::scope(Section section)
+    {
+        return Scope(this, section);
+    }
+
+    void Frame_profiler::end_frame()
+    {
+        for (std::size_t i = 0; i < timings_.size(); ++i)
+        {
+            Timing& timing = timings_[i];
+            assert(!timing.active);
+
+            if (timing.ran) {
+                sections_[i].cpu_ms.add(timing.cpu_ms);
+                timing.ran = false;
+            }
+
+            // Oldest first. Results come in order, so past the first one
+            // still pending none is in yet; those are read by a later frame.
+            for (unsigned k = 0; k < num_queries; ++k)
+            {
+                const unsigned slot = (timing.next + k) % num_queries;
+                if (!timing.pending[slot]) {
+                    continue;
+                }
+
+                GLint available = 0;
+                ::glGetQueryObjectiv(timing.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available) {
+                    break;
+                }
+
+                GLuint64 elapsed_ns = 0;
+                ::glGetQueryObjectui64v(timing.queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+                sections_[i].gpu_ms.add(static_cast<double>(elapsed_ns) / 1.0e6);
+
+                timing.pending[slot] = false;
+            }
+        }
+
+        check_opengl_error();
+    }
+
+    const std::vector<Frame_profiler::Section_stats>& Frame_profiler::sections() const
+    {
+        return sections_;
+    }
+
+    std::string Frame_profiler::report() const
+    {
+        std::string text;
+        char line[160];
+
+        std::snprintf(line, sizeof(line), "%-24s %9s %9s %9s %9s\n", "section", "cpu avg", "cpu max", "gpu avg", "gpu max");
+        text += line;
+
+        for (const auto& section : sections_)
+        {
+            std::snprintf(line,
+                          sizeof(line),
+                          "%-24.24s %9.3f %9.3f %9.3f %9.3f\n",
+                          section.name.c_str(),
+                          section.cpu_ms.average(),
+                          section.cpu_ms.max(),
+                          section.gpu_ms.average(),
+                          section.gpu_ms.max());
+            text += line;
+        }
+
+        return text;
+    }
+
+} // namespace opengl
+} // namespace kgfx
@@ -0,0 +1,85 @@
+#include <kgfx/opengl/instance_buffer.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "check_opengl_error.hpp"
+#include <cstddef>
+
+namespace kgfx {
+namespace opengl {
+
+    Instance_buffer::Instance_buffer(Instance_buffer&& rhs) noexcept
+        : buffer_{rhs.buffer_}
+        , size_{rhs.size_}
+    {
+        rhs.buffer_ = 0;
+        rhs.size_ = 0;
+    }
+
+    Instance_buffer::~Instance_buffer()
+    {
+        if (buffer_ != 0)
+        {
+            ::glDeleteBuffers(1, &buffer_);
+            State_cache::current().buffer_deleted(buffer_);
+        }
+    }
+
+    void Instance_buffer::upload(const Instance_builder& builder)
+    {
+        upload(builder.data(), builder.size());
+    }
+
+    void Instance_buffer::upload(const Instance* instances, std::size_t count)
+    {
+        if (0 == buffer_)
+        {
+            ::glGenBuffers(1, &buffer_);
+        }
+
+        State_cache::current().bind_buffer(GL_ARRAY_BUFFER, buffer_);
+        ::glBufferData(GL_ARRAY_BUFFER,
+                       sizeof(Instance) * count,
+                       count > 0 ? instances : nullptr,
+                       GL_STREAM_DRAW);
+
+        check_opengl_error();
+
+        size_ = count;
+    }
+
+    std::size_t Instance_buffer::size() const
+    {
+        return size_;
+    }
+
+    void Instance_buffer::setup_attributes()
+    {
+        // A mat4 attribute takes four consecutive locations, one per column.
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            const GLuint index = first_attribute + column;
+            ::glVertexAttribFormat(index,
+                                   4,
+                                   GL_FLOAT,
+                                   GL_FALSE,
+                                   static_cast<GLuint>(offsetof(Instance, transform) + sizeof(glm::vec4) * column));
+            ::glVertexAttribBinding(index, binding);
+            ::glEnableVertexAttribArray(index);
+        }
+
+        const GLuint color = first_attribute + 4;
+        ::glVertexAttribFormat(color, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(Instance, color)));
+        ::glVertexAttribBinding(color, binding);
+        ::glEnableVertexAttribArray(color);
+
+        ::glVertexBindingDivisor(binding, 1);
+
+        check_opengl_error();
+    }
+
+    void Instance_buffer::bind() const
+    {
+        ::glBindVertexBuffer(binding, buffer_, 0, sizeof(Instance));
+    }
+
+} // namespace opengl
+} // namespace kgfx
@@ -1,32 +1,27 @@
 #include <kgfx/opengl/mesh.hpp>
+#include <kgfx/opengl/instance_buffer.hpp>
+#include <kgfx/opengl/state_cache.hpp>
 #include "check_opengl_error.hpp"
+#include "vertex_attributes.hpp"
+#include <cassert>
+#include <stdexcept>
 
 namespace kgfx {
 namespace opengl {
 
-    Mesh::Mesh(const Triangle_mesh<>& source)
-    { 
-        setup_vertex_buffer_object(&source.vertices[0], 
-                                   source.vertices.size());
-
-        if (!source.triangles.empty()) {
-            setup_element_buffer_object(&source.triangles[0].v0, 
-                                        source.triangles.size()*3);
-        }
-
-        setup_vertex_array_object();
-    }
-
     Mesh::Mesh(Mesh&& rhs) noexcept
         : vertex_buffer_object_{rhs.vertex_buffer_object_}
         , vertex_array_object_{rhs.vertex_array_object_}
         , element_buffer_object_{rhs.element_buffer_object_}
         , render_count_{rhs.render_count_}
+        , draw_mode_{rhs.draw_mode_}
+        , instance_attributes_{rhs.instance_attributes_}
     {
         rhs.vertex_buffer_object_ = 0;
         rhs.vertex_array_object_ = 0;
         rhs.element_buffer_object_ = 0;
         rhs.render_count_ = 0;
+        rhs.instance_attributes_ = false;
     }
 
     Mesh::~Mesh()
@@ -39,20 +34,25 @@ namespace opengl {
         if (element_buffer_object_ != 0)
         {
             ::glDeleteBuffers(1, &element_buffer_object_);
+            State_cache::current().buffer_deleted(element_buffer_object_);
             element_buffer_object_ = 0;
         }
 
         if (vertex_buffer_object_ != 0)
         {
             ::glDeleteBuffers(1, &vertex_buffer_object_);
+            State_cache::current().buffer_deleted(vertex_buffer_object_);
             vertex_buffer_object_ = 0;
         }
 
         if (vertex_array_object_ != 0)
         {
             ::glDeleteVertexArrays(1, &vertex_array_object_);
+            State_cache::current().vertex_array_deleted(vertex_array_object_);
             vertex_array_object_ = 0;
         }
+
+        instance_attributes_ = false;
     }
 
     Mesh::operator bool() const
@@ -60,6 +60,11 @@ namespace opengl {
         return vertex_array_object_ != 0;
     }
 
+    GLuint Mesh::vertex_array() const
+    {
+        return vertex_array_object_;
+    }
+
     void Mesh::swap(Mesh& rhs)
     {
         std::swap(vertex_buffer_object_, rhs.vertex_buffer_object_);
@@ -69,16 +74,29 @@ namespace opengl {
         std::swap(render_count_, rhs.render_count_);
 
         std::swap(draw_mode_, rhs.draw_mode_);
+
+        std::swap(instance_attributes_, rhs.instance_attributes_);
     }
 
-    void Mesh::load_mesh(const Triangle_mesh<>& source)
+    void Mesh::upload(const void* vertices,
+                      std::size_t vertex_count,
+                      const Vertex_format& format,
+                      const Triangle* triangles,
+                      std::size_t triangle_count)
     {
-        destroy();
+        static_assert(sizeof(Triangle) == 3 * sizeof(GLuint), "Triangles are uploaded as indices.");
 
-        Mesh mesh(source);
-        if (mesh) {
-            mesh.swap(*this);
+        if (0 == vertex_count) {
+            return;
         }
+
+        setup_vertex_buffer_object(vertices, vertex_count, format.stride);
+
+        if (triangle_count > 0) {
+            setup_element_buffer_object(&triangles[0].v0, triangle_count * 3);
+        }
+
+        setup_vertex_array_object(format);
     }
 
     /*void Mesh::set_draw_mode(GLenum draw_mode)
@@ -86,22 +104,21 @@ namespace opengl {
         draw_mode_ = draw_mode;
     }*/
 
-    void Mesh::setup_vertex_buffer_object(const Vertex* vertices,
-                                          size_t vertex_count)
+    void Mesh::setup_vertex_buffer_object(const void* vertices,
+                                          size_t vertex_count,
+                                          size_t vertex_size)
     {
         ::glGenBuffers(1, &vertex_buffer_object_);
 
-        ::glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
+        State_cache::current().bind_buffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
 
-        const GLsizeiptr dataSize = sizeof(Vertex) * vertex_count;
+        const GLsizeiptr dataSize = vertex_size * vertex_count;
 
         ::glBufferData(GL_ARRAY_BUFFER,
                        dataSize,
-                       &vertices[0],
+                       vertices,
                        GL_STATIC_DRAW);
 
-        ::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
         check_opengl_error();
 
         render_count_ = static_cast<GLuint>(vertex_count);
@@ -112,34 +129,141 @@ namespace opengl {
     {
         assert(indices);
 
+        // Not through GL_ELEMENT_ARRAY_BUFFER, which would change the index
+        // buffer of whatever vertex array is bound.
         ::glGenBuffers(1, &element_buffer_object_);
-        ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_);
+        State_cache::current().bind_buffer(GL_COPY_WRITE_BUFFER, element_buffer_object_);
 
         const size_t index_buffer_size = sizeof(GLuint) * index_count;
-        ::glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+        ::glBufferData(GL_COPY_WRITE_BUFFER,
                        index_buffer_size,
                        &indices[0],
                        GL_STATIC_DRAW);
 
-        ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
         render_count_ = static_cast<GLuint>(index_count); // ???
 
         check_opengl_error();
     }
 
-    void Mesh::setup_vertex_array_object()
+    namespace {
+
+        void* map_new_buffer(GLenum target,
+                             GLuint& buffer,
+                             GLsizeiptr size)
+        {
+            ::glGenBuffers(1, &buffer);
+            State_cache::current().bind_buffer(target, buffer);
+
+            // Allocate storage only; the caller fills it through the mapping.
+            ::glBufferData(target, size, nullptr, GL_STATIC_DRAW);
+
+            void* ptr = ::glMapBufferRange(target,
+                                           0,
+                                           size,
+                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+            check_opengl_error();
+
+            if (nullptr == ptr) {
+                throw std::runtime_error("Failed to map buffer.");
+            }
+
+            return ptr;
+        }
+
+        void unmap_buffer(GLenum target, GLuint buffer)
+        {
+            State_cache::current().bind_buffer(target, buffer);
+            const GLboolean intact = ::glUnmapBuffer(target);
+
+            check_opengl_error();
+
+            if (GL_FALSE == intact) {
+                throw std::runtime_error("Buffer contents lost while mapped.");
+            }
+        }
+
+    } // namespace
+
+    bool Mesh::map_buffers(const Mesh_size& size,
+                           Vertex*& vertices,
+                           Triangle*& triangles)
+    {
+        static_assert(sizeof(Triangle) == 3 * sizeof(GLuint), "Triangles are uploaded as indices.");
+        assert(vertex_buffer_object_ == 0);
+
+        if (0 == size.num_vertices) {
+            return false;
+        }
+
+        vertices = static_cast<Vertex*>(map_new_buffer(GL_ARRAY_BUFFER,
+                                                       vertex_buffer_object_,
+                                                       sizeof(Vertex) * size.num_vertices));
+
+        render_count_ = static_cast<GLuint>(size.num_vertices);
+
+        if (size.num_triangles > 0) {
+            triangles = static_cast<Triangle*>(map_new_buffer(GL_COPY_WRITE_BUFFER,
+                                                              element_buffer_object_,
+                                                              sizeof(Triangle) * size.num_triangles));
+
+            render_count_ = static_cast<GLuint>(size.num_triangles * 3);
+        }
+
+        return true;
+    }
+
+    void Mesh::unmap_buffers()
+    {
+        unmap_buffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
+
+        if (element_buffer_object_ != 0) {
+            unmap_buffer(GL_COPY_WRITE_BUFFER, element_buffer_object_);
+        }
+
+        setup_vertex_array_object();
+    }
+
+    void Mesh::allocate_buffers(std::size_t num_vertices, std::size_t num_indices)
+    {
+        assert(vertex_buffer_object_ == 0);
+        assert(num_vertices > 0);
+
+        State_cache& state = State_cache::current();
+
+        ::glGenBuffers(1, &vertex_buffer_object_);
+        state.bind_buffer(GL_COPY_WRITE_BUFFER, vertex_buffer_object_);
+        ::glBufferData(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * num_vertices, nullptr, GL_STATIC_DRAW);
+
+        render_count_ = static_cast<GLuint>(num_vertices);
+
+        if (num_indices > 0) {
+            ::glGenBuffers(1, &element_buffer_object_);
+            state.bind_buffer(GL_COPY_WRITE_BUFFER, element_buffer_object_);
+            ::glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * num_indices, nullptr, GL_STATIC_DRAW);
+
+            render_count_ = static_cast<GLuint>(num_indices);
+        }
+
+        check_opengl_error();
+
+        setup_vertex_array_object();
+    }
+
+    void Mesh::setup_vertex_array_object(const Vertex_format& format)
     {
         assert(vertex_array_object_ == 0);
         assert(vertex_buffer_object_ != 0);
 
+        State_cache& state = State_cache::current();
+
         ::glGenVertexArrays(1, &vertex_array_object_);
-        ::glBindVertexArray(vertex_array_object_);
+        state.bind_vertex_array(vertex_array_object_);
 
         check_opengl_error();
 
         // Vertex Buffer Object
-        ::glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
+        state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
 
         check_opengl_error();
 
@@ -149,32 +273,12 @@ namespace opengl {
             ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_);
         }
 
-        const unsigned NUM_ARRAYS = 3;
-        for (GLuint index = 0, offset = 0;
-             index < NUM_ARRAYS;
-             ++index)
-        {
-            ::glEnableVertexAttribArray(index);
-
-            const GLboolean normalize = GL_FALSE;
-            ::glVertexAttribPointer(index,
-                                    3,
-                                    GL_FLOAT,
-                                    normalize,
-                                    sizeof(Vertex),
-                                    reinterpret_cast<const GLvoid*>(static_cast<unsigned long long>(offset)));
-
-            offset += sizeof(glm::vec3);
-
-            check_opengl_error();
-        }
-
-        ::glBindVertexArray(0);
+        setup_vertex_attributes(format);
     }
 
     void Mesh::render()
     {
-        ::glBindVertexArray(vertex_array_object_);
+        State_cache::current().bind_vertex_array(vertex_array_object_);
 
         if (0 == element_buffer_object_)
         {
@@ -188,8 +292,51 @@ namespace opengl {
         }
 
         check_opengl_error();
+    }
+
+    void Mesh::render_instanced(const Instance_buffer& instances)
+    {
+        render_instanced(instances, 0, instances.size());
+    }
+
+    void Mesh::render_instanced(const Instance_buffer& instances,
+                                std::size_t first,
+                                std::size_t count)
+    {
+        assert(first + count <= instances.size());
+
+        if (0 == count) {
+            return;
+        }
 
-        ::glBindVertexArray(0);
+        State_cache::current().bind_vertex_array(vertex_array_object_);
+        if (!instance_attributes_) {
+            Instance_buffer::setup_attributes();
+            instance_attributes_ = true;
+        }
+
+        instances.bind();
+
+        const GLuint base_instance = static_cast<GLuint>(first);
+        if (0 == element_buffer_object_)
+        {
+            ::glDrawArraysInstancedBaseInstance(draw_mode_,
+                                                0,
+                                                render_count_,
+                                                static_cast<GLsizei>(count),
+                                                base_instance);
+        }
+        else
+        {
+            ::glDrawElementsInstancedBaseInstance(GL_TRIANGLES,
+                                                  render_count_,
+                                                  GL_UNSIGNED_INT,
+                                                  0,
+                                                  static_cast<GLsizei>(count),
+                                                  base_instance);
+        }
+
+        check_opengl_error();
     }
 
 } // namespace opengl
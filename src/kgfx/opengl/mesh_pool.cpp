@@ -0,0 +1,299 @@
+#include <kgfx/opengl/mesh_pool.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "check_opengl_error.hpp"
+#include "vertex_attributes.hpp"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace kgfx {
+namespace opengl {
+
+    Mesh_pool::Mesh_pool(std::size_t max_vertices, std::size_t max_indices)
+        : vertex_allocator_(max_vertices)
+        , index_allocator_(max_indices)
+    {
+        create_buffers(vertex_buffer_object_, element_buffer_object_);
+        setup_vertex_array_object();
+    }
+
+    Mesh_pool::~Mesh_pool()
+    {
+        destroy();
+    }
+
+    void Mesh_pool::destroy()
+    {
+        if (vertex_array_object_ != 0)
+        {
+            ::glDeleteVertexArrays(1, &vertex_array_object_);
+            State_cache::current().vertex_array_deleted(vertex_array_object_);
+            vertex_array_object_ = 0;
+        }
+
+        if (element_buffer_object_ != 0)
+        {
+            ::glDeleteBuffers(1, &element_buffer_object_);
+            State_cache::current().buffer_deleted(element_buffer_object_);
+            element_buffer_object_ = 0;
+        }
+
+        if (vertex_buffer_object_ != 0)
+        {
+            ::glDeleteBuffers(1, &vertex_buffer_object_);
+            State_cache::current().buffer_deleted(vertex_buffer_object_);
+            vertex_buffer_object_ = 0;
+        }
+    }
+
+    void Mesh_pool::create_buffers(GLuint& vertex_buffer, GLuint& index_buffer) const
+    {
+        State_cache& state = State_cache::current();
+
+        ::glGenBuffers(1, &vertex_buffer);
+        state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
+        ::glBufferData(GL_ARRAY_BUFFER,
+                       sizeof(Vertex) * vertex_allocator_.capacity(),
+                       nullptr,
+                       GL_STATIC_DRAW);
+
+        ::glGenBuffers(1, &index_buffer);
+        state.bind_buffer(GL_COPY_WRITE_BUFFER, index_buffer);
+        ::glBufferData(GL_COPY_WRITE_BUFFER,
+                       sizeof(GLuint) * index_allocator_.capacity(),
+                       nullptr,
+                       GL_STATIC_DRAW);
+
+        check_opengl_error();
+    }
+
+    void Mesh_pool::setup_vertex_array_object()
+    {
+        assert(vertex_array_object_ == 0);
+
+        State_cache& state = State_cache::current();
+
+        ::glGenVertexArrays(1, &vertex_array_object_);
+        state.bind_vertex_array(vertex_array_object_);
+
+        state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
+        ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_);
+
+        setup_vertex_attributes();
+    }
+
+    Mesh_pool::Mesh_id Mesh_pool::allocate(const Triangle_mesh<>& source)
+    {
+        static_assert(sizeof(Triangle) == 3 * sizeof(GLuint), "Triangles are uploaded as indices.");
+        assert(!source.vertices.empty());
+
+        // Unindexed meshes get the trivial index list.
+        std::vector<GLuint> sequential;
+        const GLuint* indices = source.triangles.empty() ? nullptr : &source.triangles[0].v0;
+        std::size_t num_indices = source.triangles.size() * 3;
+        if (nullptr == indices)
+        {
+            sequential.resize(source.vertices.size());
+            for (std::size_t i = 0; i < sequential.size(); ++i)
+            {
+                sequential[i] = static_cast<GLuint>(i);
+            }
+            indices = sequential.data();
+            num_indices = sequential.size();
+        }
+
+        Entry entry;
+        entry.num_vertices = source.vertices.size();
+        entry.num_indices = num_indices;
+        entry.live = true;
+
+        auto try_allocate = [&]() {
+            if (!vertex_allocator_.allocate(entry.num_vertices, entry.first_vertex)) {
+                return false;
+            }
+
+            if (!index_allocator_.allocate(entry.num_indices, entry.first_index)) {
+                vertex_allocator_.free(entry.first_vertex, entry.num_vertices);
+                return false;
+            }
+
+            return true;
+        };
+
+        if (!try_allocate())
+        {
+            const auto vertex_stats = vertex_allocator_.stats();
+            const auto index_stats = index_allocator_.stats();
+            if (vertex_stats.free < entry.num_vertices || index_stats.free < entry.num_indices) {
+                throw std::runtime_error("Mesh pool is full.");
+            }
+
+            defragment();
+
+            if (!try_allocate()) {
+                throw std::runtime_error("Mesh pool is full.");
+            }
+        }
+
+        State_cache& state = State_cache::current();
+
+        state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer_object_);
+        ::glBufferSubData(GL_ARRAY_BUFFER,
+                          sizeof(Vertex) * entry.first_vertex,
+                          sizeof(Vertex) * entry.num_vertices,
+                          &source.vertices[0]);
+
+        state.bind_buffer(GL_COPY_WRITE_BUFFER, element_buffer_object_);
+        ::glBufferSubData(GL_COPY_WRITE_BUFFER,
+                          sizeof(GLuint) * entry.first_index,
+                          sizeof(GLuint) * entry.num_indices,
+                          indices);
+
+        check_opengl_error();
+
+        Mesh_id id = 0;
+        if (!free_ids_.empty())
+        {
+            id = free_ids_.back();
+            free_ids_.pop_back();
+            entries_[id] = entry;
+        }
+        else
+        {
+            id = static_cast<Mesh_id>(entries_.size());
+            entries_.push_back(entry);
+        }
+
+        return id;
+    }
+
+    void Mesh_pool::free(Mesh_id id)
+    {
+        assert(id < entries_.size() && entries_[id].live);
+
+        Entry& entry = entries_[id];
+        vertex_allocator_.free(entry.first_vertex, entry.num_vertices);
+        index_allocator_.free(entry.first_index, entry.num_indices);
+        entry.live = false;
+
+        free_ids_.push_back(id);
+    }
+
+    void Mesh_pool::defragment()
+    {
+        // Live meshes in buffer order, so they keep their relative order when
+        // packed into the new buffers.
+        std::vector<Mesh_id> live;
+        for (Mesh_id id = 0; id < entries_.size(); ++id)
+        {
+            if (entries_[id].live) {
+                live.push_back(id);
+            }
+        }
+
+        std::sort(live.begin(), live.end(), [this](Mesh_id a, Mesh_id b) {
+            return entries_[a].first_vertex < entries_[b].first_vertex;
+        });
+
+        // Copy into fresh buffers; copies within one buffer must not overlap.
+        GLuint vertex_buffer = 0;
+        GLuint index_buffer = 0;
+        create_buffers(vertex_buffer, index_buffer);
+
+        State_cache& state = State_cache::current();
+
+        vertex_allocator_.reset(vertex_allocator_.capacity());
+        index_allocator_.reset(index_allocator_.capacity());
+
+        for (Mesh_id id : live)
+        {
+            Entry& entry = entries_[id];
+
+            std::size_t first_vertex = 0;
+            std::size_t first_index = 0;
+            vertex_allocator_.allocate(entry.num_vertices, first_vertex);
+            index_allocator_.allocate(entry.num_indices, first_index);
+
+            state.bind_buffer(GL_COPY_READ_BUFFER, vertex_buffer_object_);
+            state.bind_buffer(GL_COPY_WRITE_BUFFER, vertex_buffer);
+            ::glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                                  GL_COPY_WRITE_BUFFER,
+                                  sizeof(Vertex) * entry.first_vertex,
+                                  sizeof(Vertex) * first_vertex,
+                                  sizeof(Vertex) * entry.num_vertices);
+
+            state.bind_buffer(GL_COPY_READ_BUFFER, element_buffer_object_);
+            state.bind_buffer(GL_COPY_WRITE_BUFFER, index_buffer);
+            ::glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                                  GL_COPY_WRITE_BUFFER,
+                                  sizeof(GLuint) * entry.first_index,
+                                  sizeof(GLuint) * first_index,
+                                  sizeof(GLuint) * entry.num_indices);
+
+            entry.first_vertex = first_vertex;
+            entry.first_index = first_index;
+        }
+
+        destroy();
+        vertex_buffer_object_ = vertex_buffer;
+        element_buffer_object_ = index_buffer;
+        setup_vertex_array_object();
+
+        check_opengl_error();
+    }
+
+    Mesh_pool::Stats Mesh_pool::stats() const
+    {
+        Stats s;
+        s.vertices = vertex_allocator_.stats();
+        s.indices = index_allocator_.stats();
+        s.num_meshes = entries_.size() - free_ids_.size();
+        s.vertex_bytes_used = sizeof(Vertex) * s.vertices.used;
+        s.index_bytes_used = sizeof(GLuint) * s.indices.used;
+        return s;
+    }
+
+    void Mesh_pool::bind() const
+    {
+        State_cache::current().bind_vertex_array(vertex_array_object_);
+    }
+
+    void Mesh_pool::render(Mesh_id id) const
+    {
+        assert(id < entries_.size() && entries_[id].live);
+
+        const Entry& entry = entries_[id];
+        ::glDrawElementsBaseVertex(GL_TRIANGLES,
+                                   static_cast<GLsizei>(entry.num_indices),
+                                   GL_UNSIGNED_INT,
+                                   reinterpret_cast<const GLvoid*>(sizeof(GLuint) * entry.first_index),
+                                   static_cast<GLint>(entry.first_vertex));
+    }
+
+    Draw_elements_indirect_command Mesh_pool::draw_command(Mesh_id id) const
+    {
+        assert(id < entries_.size() && entries_[id].live);
+
+        const Entry& entry = entries_[id];
+
+        Draw_elements_indirect_command command;
+        command.count = static_cast<GLuint>(entry.num_indices);
+        command.first_index = static_cast<GLuint>(entry.first_index);
+        command.base_vertex = static_cast<GLint>(entry.first_vertex);
+        return command;
+    }
+
+    void Mesh_pool::render(const std::vector<Mesh_id>& meshes) const
+    {
+        bind();
+
+        for (Mesh_id id : meshes)
+        {
+            render(id);
+        }
+
+        check_opengl_error();
+    }
+
+} // namespace opengl
+} // namespace kgfx
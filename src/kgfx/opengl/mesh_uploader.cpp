@@ -0,0 +1,266 @@
+#include <kgfx/opengl/mesh_uploader.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "check_opengl_error.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace kgfx {
+namespace opengl {
+
+    Mesh_uploader::Mesh_uploader(GLsizeiptr frame_budget, unsigned num_threads)
+        : staging_(std::max<GLsizeiptr>(frame_budget & ~GLsizeiptr(3), 4))
+    {
+        assert(num_threads > 0);
+
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+
+    Mesh_uploader::~Mesh_uploader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        wake_.notify_all();
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+
+        for (auto& entry : entries_)
+        {
+            if (entry.fence != nullptr) {
+                ::glDeleteSync(entry.fence);
+            }
+        }
+    }
+
+    Mesh_uploader::Ticket Mesh_uploader::submit(Prepare prepare)
+    {
+        Ticket ticket = 0;
+        if (!free_tickets_.empty())
+        {
+            ticket = free_tickets_.back();
+            free_tickets_.pop_back();
+        }
+        else
+        {
+            ticket = static_cast<Ticket>(entries_.size());
+            entries_.emplace_back();
+        }
+
+        entries_[ticket].state = State::preparing;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.emplace_back(ticket, std::move(prepare));
+        }
+
+        wake_.notify_one();
+        return ticket;
+    }
+
+    void Mesh_uploader::work()
+    {
+        for (;;)
+        {
+            std::pair<Ticket, Prepare> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+                if (stop_) {
+                    return;
+                }
+
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+
+            Prepared prepared;
+            prepared.ticket = job.first;
+            try
+            {
+                prepared.source = std::make_unique<Triangle_mesh<>>(job.second());
+            }
+            catch (...)
+            {
+                prepared.error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            prepared_.push_back(std::move(prepared));
+        }
+    }
+
+    void Mesh_uploader::collect_prepared()
+    {
+        std::vector<Prepared> prepared;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            prepared.swap(prepared_);
+        }
+
+        for (auto& p : prepared)
+        {
+            Entry& entry = entries_[p.ticket];
+            if (p.error || p.source->vertices.empty())
+            {
+                // Nothing to upload; take() hands out the error or an empty mesh.
+                entry.error = p.error;
+                entry.state = State::ready;
+                continue;
+            }
+
+            const Triangle_mesh<>& source = *p.source;
+            entry.mesh.allocate_buffers(source.vertices.size(), source.triangles.size() * 3);
+            entry.source = std::move(p.source);
+            entry.bytes_copied = 0;
+            entry.state = State::uploading;
+
+            upload_queue_.push_back(p.ticket);
+        }
+    }
+
+    void Mesh_uploader::poll_fences()
+    {
+        for (auto& entry : entries_)
+        {
+            if (entry.fence == nullptr) {
+                continue;
+            }
+
+            const GLenum result = ::glClientWaitSync(entry.fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                ::glDeleteSync(entry.fence);
+                entry.fence = nullptr;
+                entry.state = State::ready;
+            }
+        }
+    }
+
+    bool Mesh_uploader::copy(Entry& entry)
+    {
+        static_assert(sizeof(Vertex) % 4 == 0 && sizeof(Triangle) % 4 == 0, "Chunks are copied in words.");
+
+        const Triangle_mesh<>& source = *entry.source;
+        const GLsizeiptr vertex_bytes = sizeof(Vertex) * source.vertices.size();
+        const GLsizeiptr total_bytes = vertex_bytes + sizeof(Triangle) * source.triangles.size();
+
+        State_cache& state = State_cache::current();
+        state.bind_buffer(GL_COPY_READ_BUFFER, staging_.handle());
+
+        while (entry.bytes_copied < total_bytes)
+        {
+            // Whole words, so every chunk stays word aligned in both buffers.
+            const GLsizeiptr available = (staging_.frame_size() - staging_.frame_used()) & ~GLsizeiptr(3);
+            if (0 == available) {
+                return false;
+            }
+
+            const bool vertices = entry.bytes_copied < vertex_bytes;
+            const GLsizeiptr part_begin = vertices ? 0 : vertex_bytes;
+            const GLsizeiptr part_end = vertices ? vertex_bytes : total_bytes;
+            const GLsizeiptr offset = entry.bytes_copied - part_begin;
+            const GLsizeiptr size = std::min(part_end - entry.bytes_copied, available);
+
+            const Stream_allocation allocation = staging_.allocate(size, 4);
+            assert(allocation.data != nullptr);
+
+            const char* data = vertices ? reinterpret_cast<const char*>(source.vertices.data())
+                                        : reinterpret_cast<const char*>(source.triangles.data());
+            std::memcpy(allocation.data, data + offset, size);
+
+            state.bind_buffer(GL_COPY_WRITE_BUFFER, vertices ? entry.mesh.vertex_buffer_object_
+                                                             : entry.mesh.element_buffer_object_);
+            ::glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, allocation.offset, offset, size);
+
+            entry.bytes_copied += size;
+            stats_.bytes_uploaded += size;
+        }
+
+        return true;
+    }
+
+    void Mesh_uploader::update()
+    {
+        stats_ = Stats();
+
+        poll_fences();
+        collect_prepared();
+
+        if (!upload_queue_.empty())
+        {
+            staging_.begin_frame();
+
+            while (!upload_queue_.empty())
+            {
+                Entry& entry = entries_[upload_queue_.front()];
+                if (!copy(entry)) {
+                    break;
+                }
+
+                entry.fence = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                entry.source.reset();
+                upload_queue_.pop_front();
+            }
+
+            staging_.end_frame();
+
+            // Submit the copies now, so their fences can pass without waiting
+            // for the end of the frame.
+            ::glFlush();
+
+            check_opengl_error();
+        }
+
+        for (const auto& entry : entries_)
+        {
+            switch (entry.state)
+            {
+                case State::preparing: ++stats_.num_preparing; break;
+                case State::uploading: ++stats_.num_uploading; break;
+                case State::ready: ++stats_.num_ready; break;
+                case State::unused: break;
+            }
+        }
+    }
+
+    bool Mesh_uploader::is_ready(Ticket ticket) const
+    {
+        assert(ticket < entries_.size() && entries_[ticket].state != State::unused);
+
+        return entries_[ticket].state == State::ready;
+    }
+
+    Mesh Mesh_uploader::take(Ticket ticket)
+    {
+        assert(is_ready(ticket));
+
+        Entry& entry = entries_[ticket];
+        Mesh mesh(std::move(entry.mesh));
+        std::exception_ptr error = entry.error;
+
+        entry.error = nullptr;
+        entry.state = State::unused;
+        free_tickets_.push_back(ticket);
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return mesh;
+    }
+
+    const Mesh_uploader::Stats& Mesh_uploader::stats() const
+    {
+        return stats_;
+    }
+
+} // namespace opengl
+} // namespace kgfx
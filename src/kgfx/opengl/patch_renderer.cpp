@@ -0,0 +1,395 @@
+#include <kgfx/opengl/patch_renderer.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include <kgfx/mesh.hpp>
+#include "check_opengl_error.hpp"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <stdexcept>
+
+namespace kgfx {
+namespace opengl {
+    namespace {
+
+        const char* patch_vertex_shader_source = R"(
+            #version 430 core
+
+            layout(location = 0) in vec2 uv;
+            layout(location = 1) in uint patch_index;
+
+            layout(std430, binding = 0) readonly buffer Control_points {
+                vec4 control_points[];
+            };
+
+            uniform mat4 view_projection;
+
+            out vec3 position;
+            out vec3 normal;
+
+            vec4 bernstein(float t)
+            {
+                float s = 1.0 - t;
+                return vec4(s * s * s, 3.0 * t * s * s, 3.0 * t * t * s, t * t * t);
+            }
+
+            vec4 bernstein_derivative(float t)
+            {
+                float s = 1.0 - t;
+                return vec4(-3.0 * s * s, 3.0 * s * s - 6.0 * t * s, 6.0 * t * s - 3.0 * t * t, 3.0 * t * t);
+            }
+
+            void evaluate(vec2 p, out vec3 s, out vec3 su, out vec3 sv)
+            {
+                vec4 bu = bernstein(p.x);
+                vec4 bv = bernstein(p.y);
+                vec4 du = bernstein_derivative(p.x);
+                vec4 dv = bernstein_derivative(p.y);
+
+                s = vec3(0.0);
+                su = vec3(0.0);
+                sv = vec3(0.0);
+
+                uint base = patch_index * 16u;
+                for (int j = 0; j < 4; ++j) {
+                    vec3 row = vec3(0.0);
+                    vec3 row_du = vec3(0.0);
+                    for (int i = 0; i < 4; ++i) {
+                        vec3 c = control_points[base + uint(i + j * 4)].xyz;
+                        row += c * bu[i];
+                        row_du += c * du[i];
+                    }
+                    s += row * bv[j];
+                    su += row_du * bv[j];
+                    sv += row * dv[j];
+                }
+            }
+
+            void main()
+            {
+                vec3 su;
+                vec3 sv;
+                evaluate(uv, position, su, sv);
+
+                // Where the tangents vanish or are parallel, step towards the
+                // patch center like Bezier_patch::normal, so both take the
+                // normal at the same point. Zero for a degenerate patch.
+                normal = vec3(0.0);
+                vec2 p = uv;
+                float step = 1.0 / 4096.0;
+                for (int attempt = 0; attempt < 7; ++attempt, step *= 4.0) {
+                    if (attempt > 0) {
+                        vec3 s;
+                        evaluate(p, s, su, sv);
+                    }
+
+                    vec3 n = cross(su, sv);
+                    float length2 = dot(n, n);
+                    if (length2 > 1e-10 * dot(su, su) * dot(sv, sv) && length2 > 0.0) {
+                        normal = n / sqrt(length2);
+                        break;
+                    }
+
+                    p += (vec2(0.5) - p) * step;
+                }
+
+                gl_Position = view_projection * vec4(position, 1.0);
+            }
+        )";
+
+        const char* patch_fragment_shader_source = R"(
+            #version 430 core
+
+            in vec3 position;
+            in vec3 normal;
+
+            out vec4 color;
+
+            void main()
+            {
+                // Degenerate normals arrive as zero, see the vertex shader.
+                vec3 n = dot(normal, normal) > 0.0 ? normalize(normal) : vec3(0.0);
+                float light = max(dot(n, normalize(vec3(0.3, 1.0, -0.5))), 0.0);
+                color = vec4(vec3(0.15 + 0.85 * light), 1.0);
+            }
+        )";
+
+    } // namespace
+
+    Patch_renderer::Patch_renderer()
+        : program_(Shader(Shader::vertex_shader, patch_vertex_shader_source),
+                   Shader(Shader::fragment_shader, patch_fragment_shader_source),
+                   {"position", "normal"})
+        , view_projection_(program_.get_uniform<glm::mat4>("view_projection"))
+    {
+        set_view_projection(glm::mat4(1.0f));
+    }
+
+    Patch_renderer::~Patch_renderer()
+    {
+        destroy_patches();
+    }
+
+    void Patch_renderer::destroy_patches()
+    {
+        State_cache& state = State_cache::current();
+
+        for (auto& group : groups_)
+        {
+            ::glDeleteVertexArrays(1, &group.vertex_array_object);
+            ::glDeleteBuffers(1, &group.vertex_buffer_object);
+            ::glDeleteBuffers(1, &group.element_buffer_object);
+            state.vertex_array_deleted(group.vertex_array_object);
+            state.buffer_deleted(group.vertex_buffer_object);
+            state.buffer_deleted(group.element_buffer_object);
+        }
+
+        groups_.clear();
+        instance_patches_.clear();
+
+        if (instance_buffer_object_ != 0)
+        {
+            ::glDeleteBuffers(1, &instance_buffer_object_);
+            state.buffer_deleted(instance_buffer_object_);
+            instance_buffer_object_ = 0;
+        }
+
+        if (control_point_buffer_ != 0)
+        {
+            ::glDeleteBuffers(1, &control_point_buffer_);
+            state.buffer_deleted(control_point_buffer_);
+            control_point_buffer_ = 0;
+        }
+    }
+
+    void Patch_renderer::load_patches(const std::vector<Patch>& patches,
+                                      const std::vector<unsigned>& resolutions)
+    {
+        assert(patches.size() == resolutions.size());
+
+        destroy_patches();
+
+        if (patches.empty()) {
+            return;
+        }
+
+        // Control points, padded to vec4 for std430.
+        std::vector<glm::vec4> control_points;
+        control_points.reserve(patches.size() * 16);
+        for (const auto& patch : patches)
+        {
+            for (const auto& point : patch.get_points())
+            {
+                control_points.push_back(glm::vec4(point, 1.0f));
+            }
+        }
+
+        State_cache& state = State_cache::current();
+
+        ::glGenBuffers(1, &control_point_buffer_);
+        state.bind_buffer(GL_SHADER_STORAGE_BUFFER, control_point_buffer_);
+        ::glBufferData(GL_SHADER_STORAGE_BUFFER,
+                       sizeof(glm::vec4) * control_points.size(),
+                       control_points.data(),
+                       GL_STATIC_DRAW);
+
+        // Group patches by resolution; each group is a contiguous instance range.
+        std::map<unsigned, std::vector<unsigned>> by_resolution;
+        for (unsigned i = 0; i < patches.size(); ++i)
+        {
+            if (resolutions[i] < 2) {
+                throw std::runtime_error("Patch resolution must be at least 2.");
+            }
+
+            by_resolution[resolutions[i]].push_back(i);
+        }
+
+        for (const auto& entry : by_resolution)
+        {
+            Group group;
+            group.resolution = entry.first;
+            group.first_instance = static_cast<GLuint>(instance_patches_.size());
+            group.instance_count = static_cast<GLsizei>(entry.second.size());
+            instance_patches_.insert(instance_patches_.end(), entry.second.begin(), entry.second.end());
+            groups_.push_back(group);
+        }
+
+        ::glGenBuffers(1, &instance_buffer_object_);
+        state.bind_buffer(GL_ARRAY_BUFFER, instance_buffer_object_);
+        ::glBufferData(GL_ARRAY_BUFFER,
+                       sizeof(unsigned) * instance_patches_.size(),
+                       instance_patches_.data(),
+                       GL_STATIC_DRAW);
+
+        for (auto& group : groups_)
+        {
+            setup_group(group);
+        }
+
+        check_opengl_error();
+    }
+
+    void Patch_renderer::setup_group(Group& group)
+    {
+        const unsigned n = group.resolution;
+
+        std::vector<glm::vec2> uvs;
+        uvs.reserve(n * n);
+        for (unsigned y = 0; y < n; ++y)
+        {
+            for (unsigned x = 0; x < n; ++x)
+            {
+                uvs.push_back(glm::vec2(static_cast<float>(x) / static_cast<float>(n - 1),
+                                        static_cast<float>(y) / static_cast<float>(n - 1)));
+            }
+        }
+
+        std::vector<Triangle> triangles((n - 1) * (n - 1) * 2);
+        write_grid_triangles(triangles.data(), n, n, 0);
+        group.index_count = static_cast<GLsizei>(triangles.size() * 3);
+
+        State_cache& state = State_cache::current();
+
+        ::glGenVertexArrays(1, &group.vertex_array_object);
+        state.bind_vertex_array(group.vertex_array_object);
+
+        ::glGenBuffers(1, &group.vertex_buffer_object);
+        state.bind_buffer(GL_ARRAY_BUFFER, group.vertex_buffer_object);
+        ::glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * uvs.size(), uvs.data(), GL_STATIC_DRAW);
+        ::glEnableVertexAttribArray(0);
+        ::glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
+
+        ::glGenBuffers(1, &group.element_buffer_object);
+        ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, group.element_buffer_object);
+        ::glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Triangle) * triangles.size(), triangles.data(), GL_STATIC_DRAW);
+
+        // Patch index per instance; base instance selects the group's range.
+        state.bind_buffer(GL_ARRAY_BUFFER, instance_buffer_object_);
+        ::glEnableVertexAttribArray(1);
+        ::glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(unsigned), nullptr);
+        ::glVertexAttribDivisor(1, 1);
+
+        check_opengl_error();
+    }
+
+    void Patch_renderer::set_view_projection(const glm::mat4& view_projection)
+    {
+        program_.bind();
+        view_projection_.set(view_projection);
+    }
+
+    void Patch_renderer::render()
+    {
+        if (groups_.empty()) {
+            return;
+        }
+
+        State_cache& state = State_cache::current();
+
+        program_.bind();
+        state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 0, control_point_buffer_);
+
+        for (const auto& group : groups_)
+        {
+            state.bind_vertex_array(group.vertex_array_object);
+            ::glDrawElementsInstancedBaseInstance(GL_TRIANGLES,
+                                                  group.index_count,
+                                                  GL_UNSIGNED_INT,
+                                                  nullptr,
+                                                  group.instance_count,
+                                                  group.first_instance);
+        }
+
+        check_opengl_error();
+    }
+
+    void Patch_renderer::capture(std::vector<glm::vec3>& positions,
+                                 std::vector<glm::vec3>& normals)
+    {
+        positions.clear();
+        normals.clear();
+
+        if (groups_.empty()) {
+            return;
+        }
+
+        // Output offset (in samples) of every patch, in patch order.
+        std::vector<std::size_t> patch_offsets(instance_patches_.size());
+        std::vector<std::size_t> patch_sizes(instance_patches_.size());
+        std::size_t num_samples = 0;
+        for (const auto& group : groups_)
+        {
+            for (GLsizei i = 0; i < group.instance_count; ++i)
+            {
+                patch_sizes[instance_patches_[group.first_instance + i]] = group.resolution * group.resolution;
+            }
+        }
+
+        for (std::size_t i = 0; i < patch_sizes.size(); ++i)
+        {
+            patch_offsets[i] = num_samples;
+            num_samples += patch_sizes[i];
+        }
+
+        // Interleaved position and normal per sample.
+        const GLsizeiptr buffer_size = sizeof(glm::vec3) * 2 * num_samples;
+
+        State_cache& state = State_cache::current();
+
+        GLuint feedback_buffer = 0;
+        ::glGenBuffers(1, &feedback_buffer);
+        state.bind_buffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback_buffer);
+        ::glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, buffer_size, nullptr, GL_STATIC_READ);
+
+        {
+            program_.bind();
+            state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 0, control_point_buffer_);
+            state.bind_buffer_base(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback_buffer);
+
+            state.set_enabled(GL_RASTERIZER_DISCARD, true);
+            ::glBeginTransformFeedback(GL_POINTS);
+
+            // Points in vertex order, so the output is the grid row by row,
+            // instance after instance.
+            for (const auto& group : groups_)
+            {
+                state.bind_vertex_array(group.vertex_array_object);
+                ::glDrawArraysInstancedBaseInstance(GL_POINTS,
+                                                    0,
+                                                    group.resolution * group.resolution,
+                                                    group.instance_count,
+                                                    group.first_instance);
+            }
+
+            ::glEndTransformFeedback();
+            state.set_enabled(GL_RASTERIZER_DISCARD, false);
+        }
+
+        std::vector<glm::vec3> captured(num_samples * 2);
+        ::glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer_size, captured.data());
+        state.bind_buffer_base(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        ::glDeleteBuffers(1, &feedback_buffer);
+        state.buffer_deleted(feedback_buffer);
+
+        check_opengl_error();
+
+        // Group order to patch order.
+        positions.resize(num_samples);
+        normals.resize(num_samples);
+
+        std::size_t source = 0;
+        for (const auto& group : groups_)
+        {
+            for (GLsizei i = 0; i < group.instance_count; ++i)
+            {
+                const unsigned patch = instance_patches_[group.first_instance + i];
+                for (std::size_t k = 0; k < patch_sizes[patch]; ++k, ++source)
+                {
+                    positions[patch_offsets[patch] + k] = captured[source * 2 + 0];
+                    normals[patch_offsets[patch] + k] = captured[source * 2 + 1];
+                }
+            }
+        }
+    }
+
+} // namespace opengl
+} // namespace kgfx
@@ -0,0 +1,75 @@
+#include <kgfx/opengl/render_queue.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "check_opengl_error.hpp"
+
+namespace kgfx {
+namespace opengl {
+
+    void Render_queue::submit(unsigned layer,
+                              bool translucent,
+                              Shader_program& shader,
+                              Mesh& mesh,
+                              Shader_uniform<glm::mat4> transform_uniform,
+                              const glm::mat4& transform,
+                              float depth)
+    {
+        Keyed_index key;
+        key.key = translucent ? sort_key::translucent(layer, shader.handle(), mesh.vertex_array(), depth)
+                              : sort_key::opaque(layer, shader.handle(), mesh.vertex_array(), depth);
+        key.index = static_cast<std::uint32_t>(packets_.size());
+        keys_.push_back(key);
+
+        Packet packet;
+        packet.shader = &shader;
+        packet.mesh = &mesh;
+        packet.transform_uniform = transform_uniform;
+        packet.transform = transform;
+        packets_.push_back(packet);
+    }
+
+    void Render_queue::render()
+    {
+        stats_ = Stats();
+        if (packets_.empty()) {
+            return;
+        }
+
+        radix_sort(keys_, scratch_);
+
+        const Shader_program* shader = nullptr;
+        const Mesh* mesh = nullptr;
+        for (const auto& key : keys_)
+        {
+            Packet& packet = packets_[key.index];
+
+            if (packet.shader != shader)
+            {
+                State_cache::current().use_program(packet.shader->handle());
+                shader = packet.shader;
+                ++stats_.num_program_changes;
+            }
+
+            if (packet.mesh != mesh)
+            {
+                mesh = packet.mesh;
+                ++stats_.num_mesh_changes;
+            }
+
+            packet.transform_uniform.set(packet.transform);
+            packet.mesh->render();
+        }
+
+        check_opengl_error();
+
+        stats_.num_draws = packets_.size();
+        packets_.clear();
+        keys_.clear();
+    }
+
+    const Render_queue::Stats& Render_queue::stats() const
+    {
+        return stats_;
+    }
+
+} // namespace opengl
+} // namespace kgfx
@@ -1,29 +1,54 @@
 #include <kgfx/opengl/renderer.hpp>
+#include <kgfx/opengl/state_cache.hpp>
 #include <klib/file_io.hpp>
 #include "check_opengl_error.hpp"
 #include <SDL.h>
+#if defined(KGFX_HEADLESS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 #include <memory>
+#include <string>
 #include <cassert>
 #include <algorithm>
 
 namespace kgfx {
 namespace opengl {
 
+    struct Renderer::Headless_context {
+#if defined(KGFX_HEADLESS_EGL)
+        EGLDisplay display{EGL_NO_DISPLAY};
+        EGLContext context{EGL_NO_CONTEXT};
+        EGLSurface surface{EGL_NO_SURFACE};
+#endif
+        GLuint framebuffer{0};
+        GLuint color_buffer{0};
+        GLuint depth_buffer{0};
+    };
+
     void Renderer::run_frame()
     {
         render();
         update();
         present();
 
+        profiler_.end_frame();
+        State_cache::current().end_frame();
+
         frame_time_.next_frame();
     }
 
     void Renderer::construct_windowed(unsigned window_width,
                                       unsigned window_height,
-                                      const char* window_title) 
+                                      const char* window_title,
+                                      bool debug_context) 
     {
         assert(window_ == nullptr);
 
+        if (debug_context) {
+            ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+        }
+
         window_ = ::SDL_CreateWindow(window_title,
                                      SDL_WINDOWPOS_CENTERED,
                                      SDL_WINDOWPOS_CENTERED,
@@ -45,17 +70,181 @@ namespace opengl {
             throw std::runtime_error("glewInit failed.");
         }
 
-        ::glEnable(GL_DEPTH_TEST);
-        ::glEnable(GL_CULL_FACE);
-        ::glFrontFace(GL_CW);
-        ::glCullFace(GL_BACK);
+        width_ = window_width;
+        height_ = window_height;
+
+        setup_context_state();
 
         // Enable v-sync.
         ::SDL_GL_SetSwapInterval(1);
     }
 
+    void Renderer::construct_headless(unsigned width,
+                                      unsigned height,
+                                      bool debug_context)
+    {
+        assert(window_ == nullptr && headless_ == nullptr);
+
+#if defined(KGFX_HEADLESS_EGL)
+        auto headless = std::make_unique<Headless_context>();
+
+        // Mesa's surfaceless platform needs no display server at all.
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            ::eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display) {
+            headless->display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+
+        if (EGL_NO_DISPLAY == headless->display) {
+            headless->display = ::eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        EGLint major = 0;
+        EGLint minor = 0;
+        if (EGL_NO_DISPLAY == headless->display || !::eglInitialize(headless->display, &major, &minor)) {
+            throw std::runtime_error("Failed to initialize EGL.");
+        }
+
+        if (!::eglBindAPI(EGL_OPENGL_API)) {
+            ::eglTerminate(headless->display);
+            throw std::runtime_error("EGL has no desktop OpenGL.");
+        }
+
+        const EGLint config_attributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                             EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                             EGL_NONE };
+        EGLConfig config = nullptr;
+        EGLint num_configs = 0;
+        ::eglChooseConfig(headless->display, config_attributes, &config, 1, &num_configs);
+
+        const EGLint context_attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4,
+                                              EGL_CONTEXT_MINOR_VERSION, 5,
+                                              EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                              EGL_CONTEXT_OPENGL_DEBUG, debug_context ? EGL_TRUE : EGL_FALSE,
+                                              EGL_NONE };
+        headless->context = ::eglCreateContext(headless->display,
+                                               num_configs > 0 ? config : EGL_NO_CONFIG_KHR,
+                                               EGL_NO_CONTEXT,
+                                               context_attributes);
+        if (EGL_NO_CONTEXT == headless->context) {
+            ::eglTerminate(headless->display);
+            throw std::runtime_error("Failed to create OpenGL context.");
+        }
+
+        // Surfaceless if supported, else on a pbuffer; either way drawing
+        // goes to the framebuffer below.
+        if (!::eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless->context))
+        {
+            const EGLint pbuffer_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            if (num_configs > 0) {
+                headless->surface = ::eglCreatePbufferSurface(headless->display, config, pbuffer_attributes);
+            }
+
+            if (EGL_NO_SURFACE == headless->surface
+                || !::eglMakeCurrent(headless->display, headless->surface, headless->surface, headless->context))
+            {
+                ::eglDestroyContext(headless->display, headless->context);
+                ::eglTerminate(headless->display);
+                throw std::runtime_error("Failed to make the EGL context current.");
+            }
+        }
+
+        // Owned from here on, so the destructor cleans up after a throw.
+        headless_ = std::move(headless);
+
+        // glewInit looks for GLX, which is absent here; only the GL entry
+        // points are needed.
+        glewExperimental = GL_TRUE;
+        if (::glewContextInit() != GLEW_OK) {
+            throw std::runtime_error("glewContextInit failed.");
+        }
+
+        // Initialization may leave an error behind.
+        ::glGetError();
+
+        ::glGenRenderbuffers(1, &headless_->color_buffer);
+        ::glBindRenderbuffer(GL_RENDERBUFFER, headless_->color_buffer);
+        ::glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+        ::glGenRenderbuffers(1, &headless_->depth_buffer);
+        ::glBindRenderbuffer(GL_RENDERBUFFER, headless_->depth_buffer);
+        ::glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+        ::glGenFramebuffers(1, &headless_->framebuffer);
+        ::glBindFramebuffer(GL_FRAMEBUFFER, headless_->framebuffer);
+        ::glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless_->color_buffer);
+        ::glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless_->depth_buffer);
+
+        if (::glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            throw std::runtime_error("Offscreen framebuffer incomplete.");
+        }
+
+        ::glViewport(0, 0, width, height);
+
+        width_ = width;
+        height_ = height;
+
+        setup_context_state();
+#else
+        (void)width;
+        (void)height;
+        (void)debug_context;
+        throw std::runtime_error("Headless rendering needs kgfx built with EGL.");
+#endif
+    }
+
+    void Renderer::read_pixels(std::vector<unsigned char>& rgba) const
+    {
+        rgba.resize(std::size_t(width_) * height_ * 4);
+
+        ::glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        ::glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+        check_opengl_error();
+    }
+
+    void Renderer::setup_context_state()
+    {
+        // A new context; nothing the cache remembers applies to it.
+        State_cache& state = State_cache::current();
+        state.invalidate();
+
+        state.set_enabled(GL_DEPTH_TEST, true);
+        state.set_enabled(GL_CULL_FACE, true);
+        state.front_face(GL_CW);
+        state.cull_face(GL_BACK);
+    }
+
+    Renderer::Renderer()
+    {
+        // Draws submitted to the queue are timed here, not in the systems
+        // that submitted them.
+        render_queue_section_ = profiler_.add_section("render queue");
+    }
+
     Renderer::~Renderer() 
     {
+        // Members outlive the context; free their GL objects while it is
+        // still current.
+        profiler_.release();
+
+        if (headless_) {
+            if (headless_->color_buffer != 0) {
+                ::glDeleteFramebuffers(1, &headless_->framebuffer);
+                ::glDeleteRenderbuffers(1, &headless_->color_buffer);
+                ::glDeleteRenderbuffers(1, &headless_->depth_buffer);
+            }
+
+#if defined(KGFX_HEADLESS_EGL)
+            ::eglMakeCurrent(headless_->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (headless_->surface != EGL_NO_SURFACE) {
+                ::eglDestroySurface(headless_->display, headless_->surface);
+            }
+            ::eglDestroyContext(headless_->display, headless_->context);
+            ::eglTerminate(headless_->display);
+#endif
+        }
+
         if (context_) {
             ::SDL_GL_DeleteContext(context_);
             //context_ = nullptr;
@@ -85,12 +274,33 @@ namespace opengl {
 
     void Renderer::add_render_system(Render_system* rs)
     {
-        render_systems_.push_back(rs);
+        const std::string name(rs->name());
+
+        Profiled_system entry;
+        entry.system = rs;
+        entry.render = profiler_.add_section(name + " render");
+        entry.update = profiler_.add_section(name + " update");
+        render_systems_.push_back(entry);
     }
 
     void Renderer::remove_render_system(Render_system* rs)
     {
-        render_systems_.erase(std::find(render_systems_.begin(), render_systems_.end(), rs));
+        // Its profiler sections stay, with their history.
+        render_systems_.erase(std::find_if(render_systems_.begin(), 
+                                           render_systems_.end(), 
+                                           [rs] (const Profiled_system& entry) { 
+                                               return entry.system == rs; 
+                                           }));
+    }
+
+    Render_queue& Renderer::render_queue()
+    {
+        return render_queue_;
+    }
+
+    const Frame_profiler& Renderer::profiler() const
+    {
+        return profiler_;
     }
 
     void Renderer::render() 
@@ -99,23 +309,33 @@ namespace opengl {
 
         std::for_each(render_systems_.begin(), 
                       render_systems_.end(), 
-                      [] (Render_system* rs) { 
-                          rs->render(); 
+                      [this] (const Profiled_system& entry) { 
+                          auto scope = profiler_.scope(entry.render);
+                          entry.system->render(); 
                       });
+
+        auto scope = profiler_.scope(render_queue_section_);
+        render_queue_.render();
     }
 
     void Renderer::update() 
     {
         std::for_each(render_systems_.begin(), 
                       render_systems_.end(), 
-                      [this] (Render_system* rs) { 
-                          rs->update(frame_time_); 
+                      [this] (const Profiled_system& entry) { 
+                          auto scope = profiler_.scope(entry.update);
+                          entry.system->update(frame_time_); 
                       });
     }
 
     void Renderer::present() 
     {
-        ::SDL_GL_SwapWindow(window_);
+        if (window_) {
+            ::SDL_GL_SwapWindow(window_);
+        }
+        else {
+            ::glFlush();
+        }
     }
 
     /*Mesh_id Renderer::allocate_mesh(const Triangle_mesh<>& tri_mesh) 
@@ -1,5 +1,6 @@
 #include "check_opengl_error.hpp"
 #include <kgfx/opengl/shader.hpp>
+#include <kgfx/opengl/state_cache.hpp>
 #include <klib/file_io.hpp>
 #include <cassert>
 #include <vector>
@@ -110,13 +111,22 @@ namespace opengl {
     }
 
     GLuint link_shader_program(GLuint vertex_shader_handle,
-                               GLuint fragment_shader_handle)
+                               GLuint fragment_shader_handle,
+                               std::initializer_list<const char*> feedback_varyings = {})
     {
         GLuint program_handle = ::glCreateProgram();
 
         ::glAttachShader(program_handle, vertex_shader_handle);
         ::glAttachShader(program_handle, fragment_shader_handle);
 
+        if (feedback_varyings.size() > 0)
+        {
+            ::glTransformFeedbackVaryings(program_handle,
+                                          static_cast<GLsizei>(feedback_varyings.size()),
+                                          feedback_varyings.begin(),
+                                          GL_INTERLEAVED_ATTRIBS);
+        }
+
         ::glLinkProgram(program_handle);
 
         check_opengl_error();
@@ -150,28 +160,24 @@ namespace opengl {
         return program_handle;
     }
 
-    Shader_scope::Shader_scope(Shader_program* shader)
-        : shader_(shader)
-    { 
-        shader_->bind();
-    }
-
-    Shader_scope::Shader_scope(Shader_scope&& rhs)
-        : shader_(std::move(rhs.shader_))
+    Shader_scope::Shader_scope(Shader_program& shader)
     { 
+        shader.bind();
     }
 
-    Shader_scope::~Shader_scope()
+    Shader_program::Shader_program(const Shader& vertex_shader,
+                                   const Shader& fragment_shader)
+        : handle_{link_shader_program(vertex_shader.handle_,
+                                      fragment_shader.handle_)}
     {
-        if (shader_) {
-            shader_->unbind();
-        }
     }
 
     Shader_program::Shader_program(const Shader& vertex_shader,
-                                   const Shader& fragment_shader)
+                                   const Shader& fragment_shader,
+                                   std::initializer_list<const char*> feedback_varyings)
         : handle_{link_shader_program(vertex_shader.handle_,
-                                      fragment_shader.handle_)}
+                                      fragment_shader.handle_,
+                                      feedback_varyings)}
     {
     }
 
@@ -205,7 +211,7 @@ namespace opengl {
 
     Shader_scope Shader_program::bind_scope()
     {
-        return Shader_scope(this);
+        return Shader_scope(*this);
     }
 
     Shader_program::operator bool() const
@@ -213,16 +219,16 @@ namespace opengl {
         return handle_ != 0;
     }
 
-    void Shader_program::bind()
+    unsigned int Shader_program::handle() const
     {
-        assert(handle_ != 0);
-        ::glUseProgram(handle_);
-        check_opengl_error();
+        return handle_;
     }
 
-    void Shader_program::unbind()
+    void Shader_program::bind()
     {
-        ::glUseProgram(0);
+        assert(handle_ != 0);
+        State_cache::current().use_program(handle_);
+        check_opengl_error();
     }
     
     void Shader_program::destroy()
@@ -230,6 +236,7 @@ namespace opengl {
         if (handle_ != 0)
         {
             ::glDeleteProgram(handle_);
+            State_cache::current().program_deleted(handle_);
             handle_ = 0;
         }
     }
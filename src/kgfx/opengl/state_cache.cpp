@@ -0,0 +1,224 @@
+#include <kgfx/opengl/state_cache.hpp>
+
+namespace kgfx {
+namespace opengl {
+
+    State_cache& State_cache::current()
+    {
+        thread_local State_cache cache;
+        return cache;
+    }
+
+    State_cache::State_cache()
+    {
+        invalidate();
+    }
+
+    template <typename T>
+    bool State_cache::update(T& cached, T value)
+    {
+        if (cached == value)
+        {
+            ++stats_.skipped;
+            return false;
+        }
+
+        cached = value;
+        ++stats_.issued;
+        return true;
+    }
+
+    State_cache::Buffer_target State_cache::buffer_target(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_ARRAY_BUFFER: return array_buffer;
+            case GL_COPY_READ_BUFFER: return copy_read_buffer;
+            case GL_COPY_WRITE_BUFFER: return copy_write_buffer;
+            case GL_DRAW_INDIRECT_BUFFER: return draw_indirect_buffer;
+            case GL_PIXEL_PACK_BUFFER: return pixel_pack_buffer;
+            case GL_PIXEL_UNPACK_BUFFER: return pixel_unpack_buffer;
+            case GL_SHADER_STORAGE_BUFFER: return shader_storage_buffer;
+            case GL_TRANSFORM_FEEDBACK_BUFFER: return transform_feedback_buffer;
+            case GL_UNIFORM_BUFFER: return uniform_buffer;
+            default: return uncached_buffer_target;
+        }
+    }
+
+    State_cache::Capability State_cache::capability(GLenum capability)
+    {
+        switch (capability)
+        {
+            case GL_DEPTH_TEST: return depth_test;
+            case GL_CULL_FACE: return cull_face_capability;
+            case GL_BLEND: return blend;
+            case GL_RASTERIZER_DISCARD: return rasterizer_discard;
+            default: return uncached_capability;
+        }
+    }
+
+    void State_cache::use_program(GLuint program)
+    {
+        if (update(program_, program)) {
+            ::glUseProgram(program);
+        }
+    }
+
+    void State_cache::bind_vertex_array(GLuint vertex_array)
+    {
+        if (update(vertex_array_, vertex_array)) {
+            ::glBindVertexArray(vertex_array);
+        }
+    }
+
+    void State_cache::bind_buffer(GLenum target, GLuint buffer)
+    {
+        const Buffer_target index = buffer_target(target);
+        if (uncached_buffer_target == index)
+        {
+            ++stats_.issued;
+            ::glBindBuffer(target, buffer);
+        }
+        else if (update(buffers_[index], buffer))
+        {
+            ::glBindBuffer(target, buffer);
+        }
+    }
+
+    void State_cache::bind_buffer_base(GLenum target, GLuint index, GLuint buffer)
+    {
+        ++stats_.issued;
+        ::glBindBufferBase(target, index, buffer);
+
+        const Buffer_target generic = buffer_target(target);
+        if (generic != uncached_buffer_target) {
+            buffers_[generic] = buffer;
+        }
+    }
+
+    void State_cache::bind_buffer_range(GLenum target,
+                                        GLuint index,
+                                        GLuint buffer,
+                                        GLintptr offset,
+                                        GLsizeiptr size)
+    {
+        ++stats_.issued;
+        ::glBindBufferRange(target, index, buffer, offset, size);
+
+        const Buffer_target generic = buffer_target(target);
+        if (generic != uncached_buffer_target) {
+            buffers_[generic] = buffer;
+        }
+    }
+
+    void State_cache::program_deleted(GLuint program)
+    {
+        if (program_ == program) {
+            program_ = unknown_name;
+        }
+    }
+
+    void State_cache::vertex_array_deleted(GLuint vertex_array)
+    {
+        if (vertex_array_ == vertex_array) {
+            vertex_array_ = unknown_name;
+        }
+    }
+
+    void State_cache::buffer_deleted(GLuint buffer)
+    {
+        for (GLuint& bound : buffers_)
+        {
+            if (bound == buffer) {
+                bound = unknown_name;
+            }
+        }
+    }
+
+    void State_cache::set_enabled(GLenum capability, bool enabled)
+    {
+        const Capability index = State_cache::capability(capability);
+        if (uncached_capability == index)
+        {
+            ++stats_.issued;
+        }
+        else if (!update(capabilities_[index], enabled ? 1 : 0))
+        {
+            return;
+        }
+
+        if (enabled) {
+            ::glEnable(capability);
+        }
+        else {
+            ::glDisable(capability);
+        }
+    }
+
+    void State_cache::depth_func(GLenum func)
+    {
+        if (update(depth_func_, func)) {
+            ::glDepthFunc(func);
+        }
+    }
+
+    void State_cache::depth_mask(bool write)
+    {
+        if (update(depth_mask_, write ? 1 : 0)) {
+            ::glDepthMask(write ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    void State_cache::cull_face(GLenum mode)
+    {
+        if (update(cull_face_, mode)) {
+            ::glCullFace(mode);
+        }
+    }
+
+    void State_cache::front_face(GLenum mode)
+    {
+        if (update(front_face_, mode)) {
+            ::glFrontFace(mode);
+        }
+    }
+
+    void State_cache::invalidate()
+    {
+        program_ = unknown_name;
+        vertex_array_ = unknown_name;
+
+        for (GLuint& buffer : buffers_)
+        {
+            buffer = unknown_name;
+        }
+
+        for (int& enabled : capabilities_)
+        {
+            enabled = -1;
+        }
+
+        depth_func_ = unknown_enum;
+        depth_mask_ = -1;
+        cull_face_ = unknown_enum;
+        front_face_ = unknown_enum;
+    }
+
+    const State_cache::Stats& State_cache::stats() const
+    {
+        return stats_;
+    }
+
+    const State_cache::Stats& State_cache::frame_stats() const
+    {
+        return frame_stats_;
+    }
+
+    void State_cache::end_frame()
+    {
+        frame_stats_ = stats_;
+        stats_ = Stats();
+    }
+
+} // namespace opengl
+} // namespace kgfx
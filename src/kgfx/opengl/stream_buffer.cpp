@@ -0,0 +1,274 @@
+#include <kgfx/opengl/stream_buffer.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include "check_opengl_error.hpp"
+#include "vertex_attributes.hpp"
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace kgfx {
+namespace opengl {
+
+    Stream_buffer::Stream_buffer(GLsizeiptr frame_size, unsigned num_frames)
+        : frame_size_{frame_size}
+        , fences_(num_frames, nullptr)
+    {
+        assert(frame_size > 0);
+        assert(num_frames > 0);
+
+        GLint alignment = 0;
+        ::glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0) {
+            uniform_alignment_ = alignment;
+        }
+
+        const GLsizeiptr size = frame_size * num_frames;
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        ::glGenBuffers(1, &buffer_);
+        State_cache::current().bind_buffer(GL_COPY_WRITE_BUFFER, buffer_);
+        ::glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+
+        mapped_ = static_cast<char*>(::glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+
+        check_opengl_error();
+
+        if (nullptr == mapped_) {
+            destroy();
+            throw std::runtime_error("Failed to map stream buffer.");
+        }
+    }
+
+    Stream_buffer::Stream_buffer(Stream_buffer&& rhs) noexcept
+    {
+        swap(rhs);
+    }
+
+    Stream_buffer::~Stream_buffer()
+    {
+        destroy();
+    }
+
+    Stream_buffer& Stream_buffer::operator=(Stream_buffer&& rhs) noexcept
+    {
+        Stream_buffer tmp(std::move(rhs));
+        swap(tmp);
+        return *this;
+    }
+
+    void Stream_buffer::destroy()
+    {
+        for (auto& fence : fences_)
+        {
+            if (fence != nullptr)
+            {
+                ::glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        if (buffer_ != 0)
+        {
+            // Deleting the buffer also unmaps it.
+            ::glDeleteBuffers(1, &buffer_);
+            State_cache::current().buffer_deleted(buffer_);
+            buffer_ = 0;
+            mapped_ = nullptr;
+        }
+    }
+
+    Stream_buffer::operator bool() const
+    {
+        return mapped_ != nullptr;
+    }
+
+    void Stream_buffer::swap(Stream_buffer& rhs)
+    {
+        std::swap(buffer_, rhs.buffer_);
+        std::swap(mapped_, rhs.mapped_);
+        std::swap(frame_size_, rhs.frame_size_);
+        std::swap(frame_used_, rhs.frame_used_);
+        std::swap(uniform_alignment_, rhs.uniform_alignment_);
+        std::swap(frame_, rhs.frame_);
+        std::swap(fences_, rhs.fences_);
+    }
+
+    void Stream_buffer::begin_frame()
+    {
+        assert(buffer_ != 0 && "Default constructed stream buffer.");
+
+        GLsync& fence = fences_[frame_];
+        if (fence != nullptr)
+        {
+            const GLuint64 timeout = 1000000000; // 1 s
+            for (;;)
+            {
+                const GLenum result = ::glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+                if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+                    break;
+                }
+
+                if (result == GL_WAIT_FAILED) {
+                    throw std::runtime_error("Waiting for stream buffer fence failed.");
+                }
+            }
+
+            ::glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        frame_used_ = 0;
+    }
+
+    Stream_allocation Stream_buffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+    {
+        assert(alignment > 0);
+
+        const GLintptr start = frame_offset();
+        const GLintptr offset = (start + frame_used_ + alignment - 1) / alignment * alignment;
+
+        Stream_allocation allocation;
+        if (offset + size > start + frame_size_) {
+            return allocation;
+        }
+
+        frame_used_ = offset + size - start;
+
+        allocation.data = mapped_ + offset;
+        allocation.offset = offset;
+        return allocation;
+    }
+
+    Stream_allocation Stream_buffer::allocate_uniform(GLsizeiptr size)
+    {
+        return allocate(size, uniform_alignment_);
+    }
+
+    void Stream_buffer::end_frame()
+    {
+        assert(buffer_ != 0 && "Default constructed stream buffer.");
+        assert(fences_[frame_] == nullptr);
+
+        fences_[frame_] = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame_ = (frame_ + 1) % static_cast<unsigned>(fences_.size());
+
+        check_opengl_error();
+    }
+
+    void Stream_buffer::bind_range(GLenum target,
+                                   GLuint index,
+                                   const Stream_allocation& allocation,
+                                   GLsizeiptr size) const
+    {
+        State_cache::current().bind_buffer_range(target, index, buffer_, allocation.offset, size);
+    }
+
+    GLuint Stream_buffer::handle() const
+    {
+        return buffer_;
+    }
+
+    GLsizeiptr Stream_buffer::frame_size() const
+    {
+        return frame_size_;
+    }
+
+    GLintptr Stream_buffer::frame_offset() const
+    {
+        return frame_size_ * frame_;
+    }
+
+    GLsizeiptr Stream_buffer::frame_used() const
+    {
+        return frame_used_;
+    }
+
+    Dynamic_mesh::Dynamic_mesh(std::size_t max_vertices,
+                               std::size_t max_triangles,
+                               unsigned num_frames)
+        : vertex_stream_(sizeof(Vertex) * max_vertices, num_frames)
+        , index_stream_(sizeof(Triangle) * max_triangles, num_frames)
+    {
+        static_assert(sizeof(Triangle) == 3 * sizeof(GLuint), "Triangles are uploaded as indices.");
+
+        State_cache& state = State_cache::current();
+
+        ::glGenVertexArrays(1, &vertex_array_object_);
+        state.bind_vertex_array(vertex_array_object_);
+
+        state.bind_buffer(GL_ARRAY_BUFFER, vertex_stream_.handle());
+        ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_stream_.handle());
+
+        setup_vertex_attributes();
+    }
+
+    Dynamic_mesh::~Dynamic_mesh()
+    {
+        if (vertex_array_object_ != 0)
+        {
+            ::glDeleteVertexArrays(1, &vertex_array_object_);
+            State_cache::current().vertex_array_deleted(vertex_array_object_);
+        }
+    }
+
+    void Dynamic_mesh::begin_frame()
+    {
+        vertex_stream_.begin_frame();
+        index_stream_.begin_frame();
+
+        num_vertices_ = 0;
+        num_triangles_ = 0;
+    }
+
+    bool Dynamic_mesh::reserve(const Mesh_size& size,
+                               Vertex*& vertices,
+                               Triangle*& triangles)
+    {
+        // Both must fit, or base vertices of later additions would be off.
+        const GLsizeiptr vertex_bytes = sizeof(Vertex) * size.num_vertices;
+        const GLsizeiptr index_bytes = sizeof(Triangle) * size.num_triangles;
+        if (vertex_stream_.frame_used() + vertex_bytes > vertex_stream_.frame_size()
+            || index_stream_.frame_used() + index_bytes > index_stream_.frame_size())
+        {
+            return false;
+        }
+
+        // Element sized alignment keeps each frame's data contiguous.
+        const Stream_allocation vertex_allocation = vertex_stream_.allocate(vertex_bytes, sizeof(Vertex));
+        const Stream_allocation index_allocation = index_stream_.allocate(index_bytes, sizeof(Triangle));
+
+        if (0 == num_vertices_ && 0 == num_triangles_)
+        {
+            first_vertex_ = vertex_allocation.offset / static_cast<GLintptr>(sizeof(Vertex));
+            first_index_ = index_allocation.offset;
+        }
+
+        vertices = static_cast<Vertex*>(vertex_allocation.data);
+        triangles = static_cast<Triangle*>(index_allocation.data);
+        return true;
+    }
+
+    void Dynamic_mesh::render()
+    {
+        if (0 == num_triangles_) {
+            return;
+        }
+
+        State_cache::current().bind_vertex_array(vertex_array_object_);
+        ::glDrawElementsBaseVertex(GL_TRIANGLES,
+                                   static_cast<GLsizei>(num_triangles_ * 3),
+                                   GL_UNSIGNED_INT,
+                                   reinterpret_cast<const GLvoid*>(first_index_),
+                                   static_cast<GLint>(first_vertex_));
+
+        check_opengl_error();
+    }
+
+    void Dynamic_mesh::end_frame()
+    {
+        vertex_stream_.end_frame();
+        index_stream_.end_frame();
+    }
+
+} // namespace opengl
+} // namespace kgfx
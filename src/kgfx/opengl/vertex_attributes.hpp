@@ -0,0 +1,49 @@
+#pragma once
+#include <GL/glew.h>
+#include <kgfx/vertex_layout.hpp>
+#include "check_opengl_error.hpp"
+
+namespace kgfx {
+namespace opengl {
+
+    // Attribute pointers for vertices of 'format' in the buffer bound to
+    // GL_ARRAY_BUFFER, into the bound vertex array object.
+    inline void setup_vertex_attributes(const Vertex_format& format)
+    {
+        for (std::size_t i = 0; i < format.num_attributes; ++i)
+        {
+            const Vertex_attribute& attribute = format.attributes[i];
+
+            GLenum type = GL_FLOAT;
+            GLboolean normalize = GL_FALSE;
+            switch (attribute.type)
+            {
+            case Attribute_type::float32:
+                break;
+
+            case Attribute_type::uint8_normalized:
+                type = GL_UNSIGNED_BYTE;
+                normalize = GL_TRUE;
+                break;
+            }
+
+            ::glEnableVertexAttribArray(attribute.location);
+            ::glVertexAttribPointer(attribute.location,
+                                    static_cast<GLint>(attribute.num_components),
+                                    type,
+                                    normalize,
+                                    static_cast<GLsizei>(format.stride),
+                                    reinterpret_cast<const GLvoid*>(static_cast<unsigned long long>(attribute.offset)));
+
+            check_opengl_error();
+        }
+    }
+
+    // For kgfx::Vertex.
+    inline void setup_vertex_attributes()
+    {
+        setup_vertex_attributes(vertex_format<Vertex>());
+    }
+
+} // namespace opengl
+} // namespace kgfx
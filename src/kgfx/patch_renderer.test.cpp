@@ -0,0 +1,115 @@
+#include <catch.hpp>
+#include <kgfx/opengl/patch_renderer.hpp>
+#include "headless_renderer.test.hpp"
+#include <array>
+#include <cmath>
+#include <vector>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace {
+
+    using Patch = kgfx::opengl::Patch_renderer::Patch;
+
+    // A bumpy patch over [0, 3]^2, and a cone-like one with its top row
+    // collapsed to a point.
+    Patch make_bumpy_patch()
+    {
+        std::array<glm::vec3, 16> points;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                const float height = ((i + j) % 2 == 0) ? 1.0f : -0.5f;
+                points[i + j * 4] = glm::vec3(static_cast<float>(i), static_cast<float>(j), height);
+            }
+        }
+
+        return Patch(points);
+    }
+
+    Patch make_collapsed_patch()
+    {
+        std::array<glm::vec3, 16> points;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            const float radius = 1.0f - static_cast<float>(j) / 3.0f;
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                // Strongly curved towards the apex, so normals taken at
+                // different points near it differ.
+                const float x = radius * (static_cast<float>(i) - 1.5f);
+                const float bulge = (i == 1 || i == 2) ? 2.0f : -1.0f;
+                points[i + j * 4] = glm::vec3(x, static_cast<float>(j) * (1.0f + bulge * radius), bulge * radius);
+            }
+        }
+
+        return Patch(points);
+    }
+
+    bool near(const glm::vec3& a, const glm::vec3& b, float tolerance)
+    {
+        return std::abs(a.x - b.x) <= tolerance
+               && std::abs(a.y - b.y) <= tolerance
+               && std::abs(a.z - b.z) <= tolerance;
+    }
+
+} // namespace
+
+TEST_CASE("Patch_renderer evaluates like the CPU", "[opengl]")
+{
+    auto renderer = kgfx_test::make_headless_renderer(16, 16);
+    if (!renderer) {
+        return;
+    }
+
+    // Resolutions out of order, so capture() must undo the grouping.
+    const std::vector<Patch> patches = {make_bumpy_patch(), make_collapsed_patch(), make_bumpy_patch()};
+    const std::vector<unsigned> resolutions = {9, 5, 7};
+
+    kgfx::opengl::Patch_renderer patch_renderer;
+    patch_renderer.load_patches(patches, resolutions);
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    patch_renderer.capture(positions, normals);
+
+    REQUIRE(positions.size() == 9 * 9 + 5 * 5 + 7 * 7);
+    REQUIRE(normals.size() == positions.size());
+
+    std::size_t offset = 0;
+    for (std::size_t p = 0; p < patches.size(); ++p)
+    {
+        const unsigned n = resolutions[p];
+
+        std::vector<glm::vec3> expected_positions(n * n);
+        std::vector<glm::vec3> expected_normals(n * n);
+        patches[p].sample_grid_normals(n, n, [&](unsigned x, unsigned y, const glm::vec3& position, const glm::vec3& normal) {
+            expected_positions[x + y * n] = position;
+            expected_normals[x + y * n] = normal;
+        });
+
+        for (unsigned y = 0; y < n; ++y)
+        {
+            for (unsigned x = 0; x < n; ++x)
+            {
+                const std::size_t i = x + y * n;
+                const float tx = static_cast<float>(x) / static_cast<float>(n - 1);
+                const float ty = static_cast<float>(y) / static_cast<float>(n - 1);
+
+                // Both sides step off the apex to the same point, where the
+                // tangents are only a few hundred ulps long; the normals agree
+                // to that precision.
+                const bool at_apex = (p == 1 && y == n - 1);
+
+                REQUIRE(near(expected_positions[i], patches[p].sample(tx, ty), 1e-5f));
+                REQUIRE(near(positions[offset + i], expected_positions[i], 1e-4f));
+                REQUIRE(near(normals[offset + i], expected_normals[i], at_apex ? 1e-3f : 1e-5f));
+            }
+        }
+
+        offset += n * n;
+    }
+}
+
+#endif
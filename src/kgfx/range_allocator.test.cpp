@@ -0,0 +1,71 @@
+#include <catch.hpp>
+#include <kgfx/range_allocator.hpp>
+#include <vector>
+
+TEST_CASE("Range allocator best fit and merging", "[range_allocator]")
+{
+    kgfx::Range_allocator allocator(100);
+
+    std::size_t a = 0;
+    std::size_t b = 0;
+    std::size_t c = 0;
+    REQUIRE(allocator.allocate(10, a));
+    REQUIRE(allocator.allocate(20, b));
+    REQUIRE(allocator.allocate(30, c));
+    REQUIRE(a == 0);
+    REQUIRE(b == 10);
+    REQUIRE(c == 30);
+
+    // Holes of 10 and 20 in front of the 40 at the end.
+    allocator.free(a, 10);
+    allocator.free(c, 30);
+
+    auto stats = allocator.stats();
+    REQUIRE(stats.used == 20);
+    REQUIRE(stats.free == 80);
+    REQUIRE(stats.num_free_ranges == 2);
+    REQUIRE(stats.largest_free == 70);
+
+    // Best fit takes the small hole.
+    std::size_t d = 0;
+    REQUIRE(allocator.allocate(8, d));
+    REQUIRE(d == 0);
+
+    std::size_t too_large = 12345;
+    REQUIRE_FALSE(allocator.allocate(71, too_large));
+    REQUIRE(too_large == 12345);
+
+    // Freeing everything merges back into one range.
+    allocator.free(d, 8);
+    allocator.free(b, 20);
+    stats = allocator.stats();
+    REQUIRE(stats.num_free_ranges == 1);
+    REQUIRE(stats.largest_free == 100);
+    REQUIRE(stats.num_allocations == 0);
+    REQUIRE(stats.fragmentation() == 0.0f);
+}
+
+TEST_CASE("Range allocator fragmentation", "[range_allocator]")
+{
+    kgfx::Range_allocator allocator(64);
+
+    std::vector<std::size_t> offsets(16);
+    for (auto& offset : offsets)
+    {
+        REQUIRE(allocator.allocate(4, offset));
+    }
+
+    // Every other range free: 8 holes of 4.
+    for (std::size_t i = 0; i < offsets.size(); i += 2)
+    {
+        allocator.free(offsets[i], 4);
+    }
+
+    const auto stats = allocator.stats();
+    REQUIRE(stats.free == 32);
+    REQUIRE(stats.num_free_ranges == 8);
+    REQUIRE(stats.fragmentation() == Approx(1.0f - 4.0f / 32.0f));
+
+    std::size_t offset = 0;
+    REQUIRE_FALSE(allocator.allocate(5, offset));
+}
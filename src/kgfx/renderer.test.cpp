@@ -0,0 +1,135 @@
+#include <catch.hpp>
+#include <kgfx/opengl/renderer.hpp>
+#include <kgfx/mesh_generator.hpp>
+#include "headless_renderer.test.hpp"
+#include <vector>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        void main()
+        {
+            gl_Position = vec4(position.xy, 0.0, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 330 core
+        out vec4 color;
+        void main()
+        {
+            color = vec4(1.0, 0.0, 0.0, 1.0);
+        })";
+
+    kgfx::Triangle_mesh<> box_mesh()
+    {
+        kgfx::Triangle_mesh<> mesh;
+        mesh.generate(kgfx::Box_generator(glm::vec3(0.5f)));
+        return mesh;
+    }
+
+    class Box_system : public kgfx::Render_system
+    {
+    public:
+        Box_system()
+            : program_(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                       kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source))
+            , mesh_(box_mesh())
+        {
+        }
+
+        void render() override
+        {
+            program_.bind();
+            mesh_.render();
+        }
+
+        void update(kgfx::Frame_time&) override
+        {
+            ++num_updates;
+        }
+
+        const char* name() const override
+        {
+            return "box";
+        }
+
+        int num_updates{0};
+
+    private:
+        kgfx::opengl::Shader_program program_;
+        kgfx::opengl::Mesh mesh_;
+    };
+
+} // namespace
+
+TEST_CASE("Headless renderer runs frames", "[opengl]")
+{
+    const unsigned size = 32;
+
+    auto renderer = kgfx_test::make_headless_renderer(size, size);
+    if (!renderer) {
+        return;
+    }
+
+    Box_system box;
+    renderer->add_render_system(&box);
+
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        renderer->run_frame();
+    }
+
+    REQUIRE(box.num_updates == 3);
+
+    std::vector<unsigned char> rgba;
+    renderer->read_pixels(rgba);
+    REQUIRE(rgba.size() == size * size * 4);
+
+    auto pixel = [&](unsigned x, unsigned y) {
+        return &rgba[(y * size + x) * 4];
+    };
+
+    // The box covers the middle, the clear color the corners.
+    REQUIRE(pixel(size / 2, size / 2)[0] == 255);
+    REQUIRE(pixel(size / 2, size / 2)[1] == 0);
+    REQUIRE(pixel(0, 0)[0] == 0);
+    REQUIRE(pixel(0, 0)[1] == 255);
+
+    const auto& sections = renderer->profiler().sections();
+    REQUIRE(sections.size() == 3);
+    REQUIRE(sections[0].name == "render queue");
+    REQUIRE(sections[0].cpu_ms.size() == 3);
+    REQUIRE(sections[1].name == "box render");
+    REQUIRE(sections[1].cpu_ms.size() == 3);
+
+    renderer->remove_render_system(&box);
+}
+
+TEST_CASE("Headless renderer benchmarks", "[.][benchmark]")
+{
+    auto renderer = kgfx_test::make_headless_renderer(256, 256);
+    if (!renderer) {
+        return;
+    }
+
+    BENCHMARK("run_frame, no systems")
+    {
+        renderer->run_frame();
+    };
+
+    Box_system box;
+    renderer->add_render_system(&box);
+
+    BENCHMARK("run_frame, one box")
+    {
+        renderer->run_frame();
+    };
+
+    renderer->remove_render_system(&box);
+}
+
+#endif
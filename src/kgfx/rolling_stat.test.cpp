@@ -0,0 +1,31 @@
+#include <catch.hpp>
+#include <kgfx/rolling_stat.hpp>
+
+TEST_CASE("Rolling stat keeps the last window", "[rolling_stat]")
+{
+    kgfx::Rolling_stat stat(4);
+    REQUIRE(stat.size() == 0);
+    REQUIRE(stat.average() == 0.0);
+
+    stat.add(1.0);
+    stat.add(3.0);
+    REQUIRE(stat.size() == 2);
+    REQUIRE(stat.average() == Approx(2.0));
+    REQUIRE(stat.min() == 1.0);
+    REQUIRE(stat.max() == 3.0);
+
+    // 1 and 3 drop out.
+    stat.add(2.0);
+    stat.add(2.0);
+    stat.add(6.0);
+    stat.add(4.0);
+    REQUIRE(stat.size() == 4);
+    REQUIRE(stat.last() == 4.0);
+    REQUIRE(stat.average() == Approx(3.5));
+    REQUIRE(stat.min() == 2.0);
+    REQUIRE(stat.max() == 6.0);
+
+    stat.clear();
+    REQUIRE(stat.size() == 0);
+    REQUIRE(stat.max() == 0.0);
+}
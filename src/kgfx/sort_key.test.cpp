@@ -0,0 +1,49 @@
+#include <catch.hpp>
+#include <kgfx/sort_key.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+TEST_CASE("Radix sort matches a stable sort", "[sort_key]")
+{
+    std::mt19937_64 rng(7);
+
+    std::vector<kgfx::Keyed_index> items;
+    for (std::uint32_t i = 0; i < 5000; ++i)
+    {
+        // Few distinct high bits and many equal keys, like real sort keys.
+        const std::uint64_t key = (rng() % 4) << 60 | (rng() % 16) << 31 | (rng() % 64) << 7;
+        items.push_back({key, i});
+    }
+
+    std::vector<kgfx::Keyed_index> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const kgfx::Keyed_index& a, const kgfx::Keyed_index& b) {
+        return a.key < b.key;
+    });
+
+    std::vector<kgfx::Keyed_index> scratch;
+    kgfx::radix_sort(items, scratch);
+
+    REQUIRE(items.size() == expected.size());
+    for (std::size_t i = 0; i < items.size(); ++i)
+    {
+        REQUIRE(items[i].key == expected[i].key);
+        REQUIRE(items[i].index == expected[i].index);
+    }
+}
+
+TEST_CASE("Sort key order", "[sort_key]")
+{
+    using namespace kgfx::sort_key;
+
+    // Layer first, opaque before translucent.
+    REQUIRE(translucent(0, 9, 9, 0.0f) < opaque(1, 0, 0, 0.0f));
+    REQUIRE(opaque(0, 9, 9, 1.0f) < translucent(0, 0, 0, 1.0f));
+
+    // Opaque: by program, then front to back.
+    REQUIRE(opaque(0, 1, 5, 0.9f) < opaque(0, 2, 0, 0.1f));
+    REQUIRE(opaque(0, 1, 5, 0.1f) < opaque(0, 1, 5, 0.9f));
+
+    // Translucent: back to front regardless of state.
+    REQUIRE(translucent(0, 2, 0, 0.9f) < translucent(0, 1, 5, 0.1f));
+}
@@ -0,0 +1,74 @@
+#include <catch.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include <kgfx/opengl/mesh.hpp>
+#include <kgfx/opengl/shader.hpp>
+#include <kgfx/mesh_generator.hpp>
+#include "headless_renderer.test.hpp"
+
+#if defined(KGFX_HEADLESS_EGL)
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        void main()
+        {
+            gl_Position = vec4(position.xy, 0.0, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 330 core
+        out vec4 color;
+        void main()
+        {
+            color = vec4(1.0);
+        })";
+
+} // namespace
+
+TEST_CASE("State_cache skips repeated binds across frames", "[opengl]")
+{
+    auto renderer = kgfx_test::make_headless_renderer(16, 16);
+    if (!renderer) {
+        return;
+    }
+
+    kgfx::opengl::Shader_program program(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                                         kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source));
+
+    kgfx::Triangle_mesh<> source;
+    source.generate(kgfx::Box_generator(glm::vec3(0.5f)));
+    kgfx::opengl::Mesh mesh(source);
+
+    kgfx::opengl::State_cache& state = kgfx::opengl::State_cache::current();
+
+    // One use_program and one bind_vertex_array per frame.
+    auto draw_frame = [&]() {
+        program.bind();
+        mesh.render();
+        state.end_frame();
+        return state.frame_stats();
+    };
+
+    // Whatever creating the mesh and program bound is counted apart.
+    state.end_frame();
+    REQUIRE(state.stats().issued == 0);
+    REQUIRE(state.stats().skipped == 0);
+
+    draw_frame();
+
+    // Still bound from the frame before.
+    const kgfx::opengl::State_cache::Stats repeated = draw_frame();
+    REQUIRE(repeated.issued == 0);
+    REQUIRE(repeated.skipped == 2);
+
+    state.invalidate();
+    const kgfx::opengl::State_cache::Stats reissued = draw_frame();
+    REQUIRE(reissued.issued == 2);
+    REQUIRE(reissued.skipped == 0);
+
+    REQUIRE(state.stats().issued == 0);
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include <catch.hpp>
+#include <kgfx/opengl/stream_buffer.hpp>
+#include <kgfx/opengl/shader.hpp>
+#include <kgfx/opengl/state_cache.hpp>
+#include <kgfx/mesh_generator.hpp>
+#include "headless_renderer.test.hpp"
+#include <cstring>
+#include <vector>
+
+#if defined(KGFX_HEADLESS_EGL)
+
+TEST_CASE("Stream_buffer cycles its regions", "[opengl]")
+{
+    auto renderer = kgfx_test::make_headless_renderer(16, 16);
+    if (!renderer) {
+        return;
+    }
+
+    const GLsizeiptr frame_size = 64;
+    const unsigned num_frames = 3;
+
+    kgfx::opengl::Stream_buffer stream(frame_size, num_frames);
+    REQUIRE(stream);
+
+    // Twice around, so every fence is waited for and reused.
+    for (unsigned frame = 0; frame < 2 * num_frames + 1; ++frame)
+    {
+        stream.begin_frame();
+        REQUIRE(stream.frame_offset() == frame_size * (frame % num_frames));
+        REQUIRE(stream.frame_used() == 0);
+
+        const kgfx::opengl::Stream_allocation small = stream.allocate(3, 1);
+        const kgfx::opengl::Stream_allocation aligned = stream.allocate(16, 16);
+        REQUIRE(small.data != nullptr);
+        REQUIRE(aligned.data != nullptr);
+        REQUIRE(small.offset == stream.frame_offset());
+        REQUIRE(aligned.offset == stream.frame_offset() + 16);
+
+        // Past the end of the region.
+        REQUIRE(stream.allocate(frame_size, 1).data == nullptr);
+
+        const unsigned char value = static_cast<unsigned char>(frame + 1);
+        std::memset(aligned.data, value, 16);
+
+        stream.end_frame();
+
+        // Coherent: the GPU sees the writes without flushing.
+        ::glFinish();
+        std::vector<unsigned char> read(16);
+        kgfx::opengl::State_cache::current().bind_buffer(GL_COPY_READ_BUFFER, stream.handle());
+        ::glGetBufferSubData(GL_COPY_READ_BUFFER, aligned.offset, 16, read.data());
+        REQUIRE(read == std::vector<unsigned char>(16, value));
+    }
+
+    REQUIRE(::glGetError() == GL_NO_ERROR);
+}
+
+namespace {
+
+    const char* vertex_source = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        void main()
+        {
+            gl_Position = vec4(position.xy, 0.0, 1.0);
+        })";
+
+    const char* fragment_source = R"(
+        #version 330 core
+        out vec4 color;
+        void main()
+        {
+            color = vec4(1.0, 0.0, 0.0, 1.0);
+        })";
+
+} // namespace
+
+TEST_CASE("Dynamic_mesh draws each frame's geometry", "[opengl]")
+{
+    const unsigned size = 32;
+
+    auto renderer = kgfx_test::make_headless_renderer(size, size);
+    if (!renderer) {
+        return;
+    }
+
+    kgfx::opengl::State_cache::current().set_enabled(GL_CULL_FACE, false);
+
+    kgfx::opengl::Shader_program program(kgfx::opengl::Shader(kgfx::opengl::Shader::vertex_shader, vertex_source),
+                                         kgfx::opengl::Shader(kgfx::opengl::Shader::fragment_shader, fragment_source));
+
+    // Room for two boxes a frame, in two regions.
+    const kgfx::Box_generator small(glm::vec3(0.25f));
+    const kgfx::Box_generator large(glm::vec3(0.75f));
+    kgfx::opengl::Dynamic_mesh mesh(2 * small.size().num_vertices, 2 * small.size().num_triangles, 2);
+
+    std::vector<unsigned char> rgba;
+    auto red = [&](unsigned x, unsigned y) {
+        return rgba[(y * size + x) * 4];
+    };
+
+    program.bind();
+
+    for (unsigned frame = 0; frame < 5; ++frame)
+    {
+        const bool is_large = (frame % 2 == 1);
+
+        mesh.begin_frame();
+        REQUIRE(mesh.add(small));
+        REQUIRE(mesh.add(is_large ? large : small));
+        REQUIRE_FALSE(mesh.add(small));
+
+        ::glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mesh.render();
+        mesh.end_frame();
+
+        renderer->read_pixels(rgba);
+
+        // The center always, the outer ring only with the large box.
+        REQUIRE(red(size / 2, size / 2) == 255);
+        REQUIRE(red(size / 2 + size / 4 + 1, size / 2) == (is_large ? 255 : 0));
+        REQUIRE(red(1, 1) == 0);
+    }
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include <catch.hpp>
+#include <kgfx/stroke.hpp>
+#include <kgfx/mesh.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    using Curve = kgfx::Bezier_curve<glm::vec3, float, 4>;
+
+    Curve make_curve(const glm::vec3& p0,
+                     const glm::vec3& p1,
+                     const glm::vec3& p2,
+                     const glm::vec3& p3)
+    {
+        return Curve({{p0, p1, p2, p3}}, {{1.0f, 1.0f, 1.0f, 1.0f}});
+    }
+
+    float distance_to_polyline(const glm::vec3& p, const std::vector<glm::vec3>& polyline)
+    {
+        float d = HUGE_VALF;
+        for (std::size_t i = 0; i + 1 < polyline.size(); ++i)
+        {
+            d = std::min(d, kgfx::detail::distance_to_segment<glm::vec3, float>(p, polyline[i], polyline[i + 1]));
+        }
+        return d;
+    }
+
+    void require_front_faces(const kgfx::Triangle_mesh<>& mesh, const glm::vec3& normal)
+    {
+        for (const auto& t : mesh.triangles)
+        {
+            const glm::vec3 n = glm::cross(mesh.vertices[t.v1].position - mesh.vertices[t.v0].position,
+                                           mesh.vertices[t.v2].position - mesh.vertices[t.v0].position);
+            REQUIRE(glm::dot(n, normal) > 0.0f);
+        }
+    }
+
+} // namespace
+
+TEST_CASE("Flattening follows curvature", "[stroke]")
+{
+    std::vector<glm::vec3> straight;
+    kgfx::flatten(make_curve({0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {3.0f, 0.0f, 0.0f}, {4.0f, 0.0f, 0.0f}), 1e-3f, straight);
+    REQUIRE(straight.size() == 2);
+
+    const auto bend = make_curve({0.0f, 0.0f, 0.0f}, {4.0f, 0.0f, 0.0f}, {4.0f, 0.0f, 4.0f}, {0.0f, 0.0f, 1.0f});
+
+    std::vector<glm::vec3> coarse;
+    std::vector<glm::vec3> fine;
+    kgfx::flatten(bend, 1e-2f, coarse);
+    kgfx::flatten(bend, 1e-4f, fine);
+    REQUIRE(fine.size() > coarse.size() * 4);
+
+    for (int i = 0; i <= 1000; ++i)
+    {
+        const glm::vec3 p = bend.sample(static_cast<float>(i) / 1000.0f);
+        REQUIRE(distance_to_polyline(p, coarse) < 1e-2f);
+    }
+
+    // Chaining skips the shared point.
+    const std::size_t before = coarse.size();
+    kgfx::flatten(make_curve({0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f, 1.0f}, {-2.0f, 0.0f, 1.0f}, {-3.0f, 0.0f, 1.0f}), 1e-2f, coarse);
+    REQUIRE(coarse.size() == before + 1);
+}
+
+TEST_CASE("Stroke joins", "[stroke][mesh]")
+{
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+    SECTION("Miter")
+    {
+        const std::vector<glm::vec3> polyline = {{0.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 2.0f}};
+
+        kgfx::Triangle_mesh<> mesh;
+        mesh.generate(kgfx::Stroke_generator<glm::vec3, float>(polyline, 0.5f, up));
+        REQUIRE(mesh.vertices.size() == 6);
+        REQUIRE(mesh.triangles.size() == 4);
+        require_front_faces(mesh, up);
+
+        // Right angle: the miter vertices sit half a width out on both axes.
+        const glm::vec3 corner = mesh.vertices[2].position;
+        REQUIRE(std::abs(std::abs(corner.x - 2.0f) - 0.25f) < 1e-5f);
+        REQUIRE(std::abs(std::abs(corner.z) - 0.25f) < 1e-5f);
+    }
+
+    SECTION("Bevel")
+    {
+        const std::vector<glm::vec3> polyline = {{0.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.2f}};
+
+        kgfx::Triangle_mesh<> mesh;
+        mesh.generate(kgfx::Stroke_generator<glm::vec3, float>(polyline, 0.5f, up));
+        REQUIRE(mesh.vertices.size() == 7);
+        REQUIRE(mesh.triangles.size() == 5);
+        require_front_faces(mesh, up);
+
+        // Nothing sticks out further than the miter limit.
+        for (const auto& v : mesh.vertices)
+        {
+            float nearest = HUGE_VALF;
+            for (const auto& p : polyline)
+            {
+                nearest = std::min(nearest, glm::length(v.position - p));
+            }
+            REQUIRE(nearest <= 4.0f * 0.25f + 1e-5f);
+        }
+    }
+}
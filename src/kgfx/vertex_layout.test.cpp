@@ -0,0 +1,52 @@
+#include <catch.hpp>
+#include <kgfx/vertex_layout.hpp>
+
+namespace {
+
+    struct Slim_vertex {
+        glm::vec3 position;
+        glm::u8vec4 color;
+    };
+
+} // namespace
+
+namespace kgfx {
+
+    template <>
+    struct Vertex_layout<Slim_vertex> {
+        static constexpr Vertex_attribute attributes[] = {
+            KGFX_VERTEX_ATTRIBUTE(Slim_vertex, position, 0),
+            KGFX_VERTEX_ATTRIBUTE(Slim_vertex, color, 2),
+        };
+    };
+
+} // namespace kgfx
+
+TEST_CASE("Default vertex layout", "[vertex_layout]")
+{
+    const kgfx::Vertex_format format = kgfx::vertex_format<kgfx::Vertex>();
+
+    REQUIRE(format.stride == sizeof(kgfx::Vertex));
+    REQUIRE(format.num_attributes == 3);
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        REQUIRE(format.attributes[i].location == i);
+        REQUIRE(format.attributes[i].num_components == 3);
+        REQUIRE(format.attributes[i].type == kgfx::Attribute_type::float32);
+        REQUIRE(format.attributes[i].offset == i * sizeof(glm::vec3));
+    }
+}
+
+TEST_CASE("Custom vertex layout", "[vertex_layout]")
+{
+    const kgfx::Vertex_format format = kgfx::vertex_format<Slim_vertex>();
+
+    REQUIRE(format.stride == sizeof(Slim_vertex));
+    REQUIRE(format.stride == 16);
+    REQUIRE(format.num_attributes == 2);
+
+    REQUIRE(format.attributes[1].location == 2);
+    REQUIRE(format.attributes[1].num_components == 4);
+    REQUIRE(format.attributes[1].type == kgfx::Attribute_type::uint8_normalized);
+    REQUIRE(format.attributes[1].offset == sizeof(glm::vec3));
+}